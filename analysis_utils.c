@@ -14,6 +14,14 @@
 
 #define ARRAY_COUNT(arr) (sizeof(arr) / sizeof((arr)[0]))
 
+/* Helper: release a string from mpz_get_str(NULL, ...) through GMP's
+ * current free function (required when the limb arena is active) */
+static void free_gmp_string(char *str) {
+    void (*gmp_free)(void *, size_t);
+    mp_get_memory_functions(NULL, NULL, &gmp_free);
+    gmp_free(str, strlen(str) + 1);
+}
+
 /* Known mathematical constants for convergence detection */
 typedef struct {
     const char *name;
@@ -148,6 +156,13 @@ bool in_memory_observer(void *user_data, size_t tick, int microtick, char phase,
     AnalysisContext *ctx = (AnalysisContext *)user_data;
     RunSummary *summary = ctx->summary;
     
+    /* --- Cycle skipped event: record the period, no microtick stats --- */
+    if (phase == 'C') {
+        summary->cycle_period = state->cycle_period;
+        summary->cycle_skipped_ticks = state->cycle_skipped_ticks;
+        return true;
+    }
+    
     /* --- Phase 1: Engine Step/Magnitude Tracking (Microticks 1-10) --- */
     if (microtick >= 1 && microtick <= 10) {
         ctx->tick_count++;
@@ -207,8 +222,8 @@ bool in_memory_observer(void *user_data, size_t tick, int microtick, char phase,
             char *den_str = mpz_get_str(NULL, 10, ratio_q.den); 
             snprintf(summary->final_ratio_str, sizeof(summary->final_ratio_str),
                      "%s/%s", num_str, den_str);
-            free(num_str);
-            free(den_str);
+            free_gmp_string(num_str);
+            free_gmp_string(den_str);
 
             /* Track sign changes */
             if (ctx->ratio_count > 1.0) {
@@ -286,6 +301,9 @@ void run_summary_init(RunSummary *summary) {
     summary->ratio_range = 0.0;
     summary->ratio_mean = 0.0;
     summary->ratio_stddev = 0.0;
+    
+    summary->cycle_period = 0;
+    summary->cycle_skipped_ticks = 0;
 }
 
 void run_summary_clear(RunSummary *summary) {
@@ -326,6 +344,9 @@ void run_summary_copy(RunSummary *dest, const RunSummary *src) {
     dest->ratio_range = src->ratio_range;
     dest->ratio_mean = src->ratio_mean;
     dest->ratio_stddev = src->ratio_stddev;
+    
+    dest->cycle_period = src->cycle_period;
+    dest->cycle_skipped_ticks = src->cycle_skipped_ticks;
 }
 
 bool analyze_latest_run(const Config *config, RunSummary *summary) {
@@ -348,6 +369,8 @@ bool analyze_latest_run(const Config *config, RunSummary *summary) {
     summary->psi_fire_count = 0;
     summary->psi_triple_count = 0;
     summary->stack_max_depth = 0;
+    summary->cycle_period = 0;
+    summary->cycle_skipped_ticks = 0;
     
     /* Re-initialize GMP rational in case it was cleared */
     rational_init(&summary->final_ratio);
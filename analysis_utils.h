@@ -55,6 +55,10 @@ typedef struct {
     double ratio_range;                 /* Max - min of samples */
     double ratio_mean;                  /* Mean of υ/β samples */
     double ratio_stddev;                /* Std dev of υ/β samples */
+    
+    /* Cycle detection (Config.enable_cycle_detection) */
+    size_t cycle_period;                /* Exact state period in ticks, 0 if none */
+    size_t cycle_skipped_ticks;         /* Ticks skipped once the cycle was found */
 } RunSummary;
 
 /* Initialize run summary (allocate GMP resources) */
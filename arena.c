@@ -0,0 +1,338 @@
+/* arena.c - Per-Run GMP Limb Arena Implementation
+ *
+ * GMP passes the original block size to its free and realloc hooks, so the
+ * size class of a slab block is recomputed from that argument and blocks
+ * carry no header. Ownership is decided by address: slabs and large blocks
+ * are aligned to ARENA_SLAB_BYTES, and a process-wide two-level chunk map
+ * (one word per 1 MiB chunk of address space) names the arena that owns
+ * each chunk. Looking up a pointer is two atomic loads, from any thread and
+ * with no lock; only frees into a retired arena take retired_lock.
+ *
+ * A slab chunk owns every address in it. A large block owns only its first
+ * address, since the tail of its chunk may hold foreign memory; GMP frees
+ * and reallocates blocks by their start, so that suffices.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "arena.h"
+#include <gmp.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Thread-local storage qualifier (C11 keyword, GNU extension otherwise) */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define TRTS_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define TRTS_THREAD_LOCAL __thread
+#else
+#define TRTS_THREAD_LOCAL
+#endif
+
+#define ARENA_MIN_SHIFT   4                       /* Smallest class: 16 B */
+#define ARENA_CLASS_COUNT 13                      /* Largest class: 64 KiB */
+#define ARENA_MAX_SMALL   ((size_t)1 << (ARENA_MIN_SHIFT + ARENA_CLASS_COUNT - 1))
+#define ARENA_SLAB_SHIFT  20
+#define ARENA_SLAB_BYTES  ((size_t)1 << ARENA_SLAB_SHIFT)
+
+/* Chunk map over 48-bit addresses: 2^14 leaves of 2^14 chunk words */
+#define ARENA_MAP_LEAF_BITS 14
+#define ARENA_MAP_LEAF_SIZE ((size_t)1 << ARENA_MAP_LEAF_BITS)
+#define ARENA_MAP_ROOT_SIZE ((size_t)1 << (48 - ARENA_SLAB_SHIFT - ARENA_MAP_LEAF_BITS))
+#define ARENA_MAP_LARGE     ((uintptr_t)1)  /* Chunk word tag: large block */
+
+typedef struct FreeBlock {
+    struct FreeBlock *next;
+} FreeBlock;
+
+typedef struct Arena {
+    FreeBlock *free_list[ARENA_CLASS_COUNT];
+    char **slabs;               /* Slab bases */
+    size_t slab_count;
+    size_t slab_capacity;
+    char *bump;                 /* Uncarved tail of the newest slab */
+    size_t bump_left;
+    size_t live_bytes;
+    size_t live_blocks;
+    size_t peak_bytes;
+    size_t allocations;
+    size_t reused;
+} Arena;
+
+/* Allocator that was installed before the arena hooks */
+static void *(*base_alloc)(size_t);
+static void *(*base_realloc)(void *, size_t, size_t);
+static void (*base_free)(void *, size_t);
+static pthread_once_t hooks_once = PTHREAD_ONCE_INIT;
+
+/* Chunk words: Arena pointer, tagged ARENA_MAP_LARGE for a large block.
+ * Leaves are published once and never freed. */
+static uintptr_t *chunk_map[ARENA_MAP_ROOT_SIZE];
+
+/* Serializes frees into arenas released at run end while blocks were
+ * still live; such blocks may be freed from any thread */
+static pthread_mutex_t retired_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static TRTS_THREAD_LOCAL Arena *active_arena = NULL;
+static TRTS_THREAD_LOCAL int active_depth = 0;
+static TRTS_THREAD_LOCAL ArenaStats last_stats;
+
+/* Helper: abort on allocation failure, matching GMP's own policy */
+static void *checked(void *ptr) {
+    if (!ptr) {
+        abort();
+    }
+    return ptr;
+}
+
+/* Helper: size class index for a request of size bytes (size <= max small) */
+static int size_class(size_t size) {
+    int cls = 0;
+    size_t block = (size_t)1 << ARENA_MIN_SHIFT;
+    while (block < size) {
+        block <<= 1;
+        ++cls;
+    }
+    return cls;
+}
+
+static size_t class_bytes(int cls) {
+    return (size_t)1 << (ARENA_MIN_SHIFT + cls);
+}
+
+/* Helper: chunk word for the chunk at aligned address base, created on
+ * demand; aborts for addresses beyond the 48 bits the map covers */
+static uintptr_t *chunk_word(const void *base) {
+    uintptr_t chunk = (uintptr_t)base >> ARENA_SLAB_SHIFT;
+    size_t root = (size_t)(chunk >> ARENA_MAP_LEAF_BITS);
+    if (root >= ARENA_MAP_ROOT_SIZE) {
+        abort();
+    }
+    uintptr_t *leaf = __atomic_load_n(&chunk_map[root], __ATOMIC_ACQUIRE);
+    if (!leaf) {
+        uintptr_t *fresh = checked(calloc(ARENA_MAP_LEAF_SIZE, sizeof(uintptr_t)));
+        if (__atomic_compare_exchange_n(&chunk_map[root], &leaf, fresh, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            leaf = fresh;
+        } else {
+            free(fresh);
+        }
+    }
+    return &leaf[chunk & (ARENA_MAP_LEAF_SIZE - 1)];
+}
+
+/* Helper: record (or with NULL, clear) the owner of the aligned block at base */
+static void map_chunk(const void *base, const Arena *arena, bool large) {
+    uintptr_t word = arena ? (uintptr_t)arena | (large ? ARENA_MAP_LARGE : 0) : 0;
+    __atomic_store_n(chunk_word(base), word, __ATOMIC_RELEASE);
+}
+
+/* Helper: arena owning ptr, or NULL; *large is set for large blocks */
+static Arena *owner_of(const void *ptr, bool *large) {
+    uintptr_t p = (uintptr_t)ptr;
+    uintptr_t chunk = p >> ARENA_SLAB_SHIFT;
+    size_t root = (size_t)(chunk >> ARENA_MAP_LEAF_BITS);
+    if (root >= ARENA_MAP_ROOT_SIZE) {
+        return NULL;
+    }
+    const uintptr_t *leaf = __atomic_load_n(&chunk_map[root], __ATOMIC_ACQUIRE);
+    if (!leaf) {
+        return NULL;
+    }
+    uintptr_t word = __atomic_load_n(&leaf[chunk & (ARENA_MAP_LEAF_SIZE - 1)],
+                                     __ATOMIC_ACQUIRE);
+    *large = (word & ARENA_MAP_LARGE) != 0;
+    if (*large && (p & (ARENA_SLAB_BYTES - 1)) != 0) {
+        return NULL;            /* Tail of a large block's chunk */
+    }
+    return (Arena *)(word & ~ARENA_MAP_LARGE);
+}
+
+/* Helper: ARENA_SLAB_BYTES-aligned block of size bytes */
+static void *aligned_block(size_t size) {
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, ARENA_SLAB_BYTES, size) != 0) {
+        abort();
+    }
+    return ptr;
+}
+
+static void account_alloc(Arena *arena, size_t bytes) {
+    arena->live_bytes += bytes;
+    arena->live_blocks++;
+    arena->allocations++;
+    if (arena->live_bytes > arena->peak_bytes) {
+        arena->peak_bytes = arena->live_bytes;
+    }
+}
+
+static void account_free(Arena *arena, size_t bytes) {
+    arena->live_bytes -= bytes;
+    arena->live_blocks--;
+}
+
+/* Helper: append a fresh slab and map its chunk to the arena */
+static void add_slab(Arena *arena) {
+    if (arena->slab_count == arena->slab_capacity) {
+        size_t cap = arena->slab_capacity ? arena->slab_capacity * 2 : 8;
+        arena->slabs = checked(realloc(arena->slabs, cap * sizeof(char *)));
+        arena->slab_capacity = cap;
+    }
+    char *slab = aligned_block(ARENA_SLAB_BYTES);
+    map_chunk(slab, arena, false);
+    arena->slabs[arena->slab_count++] = slab;
+    arena->bump = slab;
+    arena->bump_left = ARENA_SLAB_BYTES;
+}
+
+static void *arena_alloc(Arena *arena, size_t size) {
+    if (size > ARENA_MAX_SMALL) {
+        void *ptr = aligned_block(size);
+        map_chunk(ptr, arena, true);
+        account_alloc(arena, size);
+        return ptr;
+    }
+
+    int cls = size_class(size);
+    size_t bytes = class_bytes(cls);
+    void *ptr;
+    if (arena->free_list[cls]) {
+        FreeBlock *block = arena->free_list[cls];
+        arena->free_list[cls] = block->next;
+        arena->reused++;
+        ptr = block;
+    } else {
+        if (arena->bump_left < bytes) {
+            add_slab(arena);
+        }
+        ptr = arena->bump;
+        arena->bump += bytes;
+        arena->bump_left -= bytes;
+    }
+    account_alloc(arena, bytes);
+    return ptr;
+}
+
+/* Release a block known to belong to arena; size is GMP's recorded size */
+static void arena_release(Arena *arena, void *ptr, size_t size, bool large) {
+    if (large) {
+        map_chunk(ptr, NULL, false);
+        account_free(arena, size);
+        free(ptr);
+        return;
+    }
+    int cls = size_class(size);
+    FreeBlock *block = ptr;
+    block->next = arena->free_list[cls];
+    arena->free_list[cls] = block;
+    account_free(arena, class_bytes(cls));
+}
+
+/* Free an arena with no live blocks (so no large blocks are left) */
+static void arena_destroy(Arena *arena) {
+    for (size_t i = 0; i < arena->slab_count; ++i) {
+        map_chunk(arena->slabs[i], NULL, false);
+        free(arena->slabs[i]);
+    }
+    free(arena->slabs);
+    free(arena);
+}
+
+/* Helper: free ptr into a retired arena, destroying it with its last block */
+static void release_retired(Arena *arena, void *ptr, size_t size, bool large) {
+    pthread_mutex_lock(&retired_lock);
+    arena_release(arena, ptr, size, large);
+    bool empty = arena->live_blocks == 0;
+    pthread_mutex_unlock(&retired_lock);
+    if (empty) {
+        arena_destroy(arena);
+    }
+}
+
+/* GMP hooks */
+
+static void *hook_alloc(size_t size) {
+    if (active_arena) {
+        return arena_alloc(active_arena, size);
+    }
+    return base_alloc(size);
+}
+
+static void hook_free(void *ptr, size_t size) {
+    if (!ptr) {
+        return;
+    }
+    bool large = false;
+    Arena *owner = owner_of(ptr, &large);
+    if (!owner) {
+        base_free(ptr, size);
+    } else if (owner == active_arena) {
+        arena_release(owner, ptr, size, large);
+    } else {
+        /* Not the active arena of this thread, so a retired one */
+        release_retired(owner, ptr, size, large);
+    }
+}
+
+static void *hook_realloc(void *ptr, size_t old_size, size_t new_size) {
+    Arena *arena = active_arena;
+    bool large = false;
+    Arena *owner = owner_of(ptr, &large);
+    if (arena && owner == arena && !large && new_size <= ARENA_MAX_SMALL
+        && size_class(old_size) == size_class(new_size)) {
+        return ptr;
+    }
+    if (!arena && !owner) {
+        return base_realloc(ptr, old_size, new_size);
+    }
+    void *fresh = hook_alloc(new_size);
+    memcpy(fresh, ptr, old_size < new_size ? old_size : new_size);
+    hook_free(ptr, old_size);
+    return fresh;
+}
+
+static void install_hooks(void) {
+    mp_get_memory_functions(&base_alloc, &base_realloc, &base_free);
+    mp_set_memory_functions(hook_alloc, hook_realloc, hook_free);
+}
+
+void arena_run_begin(void) {
+    if (active_depth++ > 0) {
+        return;
+    }
+    pthread_once(&hooks_once, install_hooks);
+    active_arena = checked(calloc(1, sizeof(Arena)));
+}
+
+void arena_run_end(ArenaStats *stats) {
+    if (active_depth == 0 || --active_depth > 0) {
+        if (stats) {
+            memset(stats, 0, sizeof(*stats));
+        }
+        return;
+    }
+    Arena *arena = active_arena;
+    active_arena = NULL;
+
+    last_stats.peak_bytes = arena->peak_bytes;
+    last_stats.slab_bytes = arena->slab_count * ARENA_SLAB_BYTES;
+    last_stats.allocations = arena->allocations;
+    last_stats.reused = arena->reused;
+    last_stats.escaped_blocks = arena->live_blocks;
+    if (stats) {
+        *stats = last_stats;
+    }
+
+    if (arena->live_blocks == 0) {
+        arena_destroy(arena);
+        return;
+    }
+    /* Blocks escaped the run: keep the memory until they are freed; the
+     * chunk map still names the arena, and the last free destroys it */
+}
+
+ArenaStats arena_last_stats(void) {
+    return last_stats;
+}
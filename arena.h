@@ -0,0 +1,53 @@
+/* arena.h - Per-Run GMP Limb Arena
+ *
+ * Opt-in pool allocator for GMP limb buffers, installed process-wide through
+ * mp_set_memory_functions the first time a run enables it.
+ *
+ * - Each thread gets its own arena, so parallel sweeps never contend on
+ *   malloc: allocations and frees of the thread's own blocks are lock-free.
+ * - Blocks up to 64 KiB come from power-of-two size classes carved out of
+ *   1 MiB slabs and are recycled through per-class free lists. Larger
+ *   blocks go straight to the underlying allocator but are still accounted.
+ * - An arena is scoped to one simulate()/simulate_stream() call and is
+ *   released in bulk at run end. If blocks escaped the run (e.g. an
+ *   observer copied a register into its own mpz), the arena is retired
+ *   instead and released once the last such block is freed.
+ * - Memory that did not come from an arena is passed to the previously
+ *   installed GMP allocator, so objects created before or outside a run
+ *   keep working. Telling the two apart is one lookup in an address map,
+ *   however many arenas are live or retired.
+ *
+ * Strings from mpz_get_str(NULL, ...) made during an arena run must be
+ * released through the GMP free function (mp_get_memory_functions), not
+ * free(). GMP requires this anyway.
+ *
+ * Limbs allocated inside a run must not be freed by another thread while
+ * that run is still active.
+ */
+
+#ifndef TRTS_ARENA_H
+#define TRTS_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Statistics for one arena run */
+typedef struct {
+    size_t peak_bytes;          /* Peak bytes handed to GMP (class-rounded) */
+    size_t slab_bytes;          /* Bytes reserved in slabs at run end */
+    size_t allocations;         /* Total allocation requests served */
+    size_t reused;              /* Requests satisfied from a free list */
+    size_t escaped_blocks;      /* Blocks still live at run end (arena retired) */
+} ArenaStats;
+
+/* Activate an arena for the calling thread. Nested calls are counted;
+ * only the outermost begin/end pair creates and releases the arena. */
+void arena_run_begin(void);
+
+/* Release the calling thread's arena in bulk and fill stats (may be NULL) */
+void arena_run_end(ArenaStats *stats);
+
+/* Statistics of the calling thread's most recent completed arena run */
+ArenaStats arena_last_stats(void);
+
+#endif /* TRTS_ARENA_H */
@@ -5,6 +5,7 @@
  */
 
 #include "config.h"
+#include <string.h>
 
 void config_init(Config *cfg) {
     /* Set default modes */
@@ -42,9 +43,30 @@ void config_init(Config *cfg) {
     cfg->enable_ratio_snapshot_logging = false;
     cfg->enable_feedback_oscillator = false;
     cfg->enable_fibonacci_gate = false;
+    cfg->enable_limb_arena = false;
+    cfg->enable_cycle_detection = false;
+    cfg->enable_multimodular_engine = false;
     
     /* Default simulation length */
     cfg->ticks = 10;
+    cfg->multimodular_threads = 0;
+    cfg->koppa_stack_depth = KOPPA_STACK_DEFAULT_DEPTH;
+    cfg->output_format = OUTPUT_FORMAT_CSV;
+    cfg->output_every = 0;
+    cfg->output_tick_from = 0;
+    cfg->output_tick_to = 0;
+    cfg->output_events = 0;
+    cfg->output_final_only = false;
+    cfg->output_queue_rows = OUTPUT_QUEUE_DEFAULT_ROWS;
+    
+    /* Test every value; too-large values would not count as prime */
+    cfg->prime_test_reps = PRIME_TEST_DEFAULT_REPS;
+    cfg->prime_test_max_bits = 0;
+    cfg->prime_too_large_is_prime = false;
+    
+    /* Parallel pattern tests only for very large operands */
+    cfg->pattern_threads = 0;
+    cfg->pattern_parallel_bits = PATTERN_PARALLEL_DEFAULT_BITS;
     
     /* Initialize rational seeds */
     rational_init(&cfg->initial_upsilon);
@@ -78,3 +100,45 @@ void config_clear(Config *cfg) {
     rational_clear(&cfg->ratio_custom_upper);
     mpz_clear(cfg->modulus_bound);
 }
+
+bool config_parse_output_events(const char *text, unsigned *mask) {
+    static const struct {
+        const char *name;
+        unsigned bit;
+    } events[] = {
+        {"psi", OUTPUT_EVENT_PSI},
+        {"rho", OUTPUT_EVENT_RHO},
+        {"mu_zero", OUTPUT_EVENT_MU_ZERO},
+        {"ratio", OUTPUT_EVENT_RATIO}
+    };
+    unsigned result = 0;
+    
+    while (*text) {
+        size_t len = strcspn(text, ",");
+        size_t i = 0;
+        while (i < sizeof(events) / sizeof(events[0]) &&
+               !(strlen(events[i].name) == len && strncmp(events[i].name, text, len) == 0)) {
+            ++i;
+        }
+        if (i == sizeof(events) / sizeof(events[0])) {
+            return false;
+        }
+        result |= events[i].bit;
+        text += len;
+        if (*text == ',') {
+            ++text;
+        }
+    }
+    
+    if (result == 0) {
+        return false;
+    }
+    *mask = result;
+    return true;
+}
+
+bool config_output_filtered(const Config *cfg) {
+    return cfg->output_every > 0 || cfg->output_tick_from > 0 ||
+           cfg->output_tick_to > 0 || cfg->output_events != 0 ||
+           cfg->output_final_only;
+}
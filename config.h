@@ -83,6 +83,33 @@ typedef enum {
 } RatioTriggerMode;
 
 
+/* File output of simulate() */
+typedef enum {
+    OUTPUT_FORMAT_CSV,     /* events.csv and values.csv (default) */
+    OUTPUT_FORMAT_BINARY   /* trace.bin, see trace.h; trts_trace2csv converts */
+} OutputFormat;
+
+/* Microtick events selecting simulate() output rows (Config.output_events) */
+enum {
+    OUTPUT_EVENT_PSI     = 1u << 0,    /* psi fired */
+    OUTPUT_EVENT_RHO     = 1u << 1,    /* rho event */
+    OUTPUT_EVENT_MU_ZERO = 1u << 2,    /* mu zero */
+    OUTPUT_EVENT_RATIO   = 1u << 3     /* ratio trigger or ratio threshold */
+};
+
+/* Default ring size of the background output writer (output_queue.h) */
+#define OUTPUT_QUEUE_DEFAULT_ROWS 64
+
+/* Default and largest depth of the multi-level koppa stack */
+#define KOPPA_STACK_DEFAULT_DEPTH 4
+#define KOPPA_STACK_MAX_DEPTH ((size_t)1 << 20)
+
+/* Default Miller-Rabin reps of the final primality tier */
+#define PRIME_TEST_DEFAULT_REPS 25
+
+/* Default operand size for parallel pattern tests (about 10^4 digits) */
+#define PATTERN_PARALLEL_DEFAULT_BITS 33220
+
 /* Master configuration structure */
 typedef struct {
     /* Modes */
@@ -100,7 +127,7 @@ typedef struct {
     /* Feature flags */
     bool dual_track_mode;                    /* Use dual track modes (upsilon/beta) */
     bool triple_psi_mode;                    /* Use 3-way ψ (υ,β,κ) → (β/κ, κ/υ, κ/β) */
-    bool multi_level_koppa;                  /* Enable 4-level koppa stack */
+    bool multi_level_koppa;                  /* Enable multi-level koppa stack */
     bool enable_asymmetric_cascade;          /* Use different track modes per microtick */
     bool enable_conditional_triple_psi;      /* Force triple ψ if 3+ primes found */
     bool enable_koppa_gated_engine;          /* Gate engine steps based on κ value */
@@ -118,9 +145,38 @@ typedef struct {
     bool enable_ratio_snapshot_logging;      /* Log ratio snapshots (analysis) */
     bool enable_feedback_oscillator;         /* Feedback oscillation mode */
     bool enable_fibonacci_gate;              /* Fibonacci gating */
+    bool enable_limb_arena;                  /* Pool GMP limbs in a per-run arena */
+    bool enable_cycle_detection;             /* Skip exact state cycles at tick boundaries */
+    bool enable_multimodular_engine;         /* Final state via residue lanes + CRT */
 
     /* Simulation parameters */
     size_t ticks;                            /* Number of ticks to simulate */
+    unsigned multimodular_threads;           /* Residue lane workers (0 = one per CPU) */
+    size_t koppa_stack_depth;                /* Multi-level koppa stack entries (1 to KOPPA_STACK_MAX_DEPTH) */
+    OutputFormat output_format;              /* Files written by simulate() */
+    
+    /* Rows written by simulate(). Within [output_tick_from, output_tick_to]
+     * a microtick is written if its tick is a multiple of output_every or
+     * it has one of the output_events; with both unset every row is. Any
+     * of these run-length collapses quiet rows in events.csv. */
+    size_t output_every;                     /* Every Nth tick (0 = off) */
+    size_t output_tick_from;                 /* First tick written (0 = start) */
+    size_t output_tick_to;                   /* Last tick written (0 = end) */
+    unsigned output_events;                  /* OUTPUT_EVENT_* mask (0 = off) */
+    bool output_final_only;                  /* Only the state after the run */
+    size_t output_queue_rows;                /* Rows buffered for the writer thread (0 = inline) */
+    
+    /* Primality tests (pattern triggers, psi strength). Values wider than
+     * prime_test_max_bits are "too large to test": they are not tested and
+     * count as prime only if prime_too_large_is_prime is set. */
+    int prime_test_reps;                     /* mpz_probab_prime_p reps (>= 1) */
+    size_t prime_test_max_bits;              /* Test size cutoff in bits (0 = none) */
+    bool prime_too_large_is_prime;           /* Result for values above the cutoff */
+    
+    /* Pattern checks on operands of pattern_parallel_bits or more run on
+     * a worker pool; results are identical to sequential evaluation */
+    unsigned pattern_threads;                /* Pattern test workers (0 = one per CPU) */
+    size_t pattern_parallel_bits;            /* Operand size to go parallel (0 = never) */
 
     /* Initial seeds (rational) */
     Rational initial_upsilon;
@@ -144,4 +200,11 @@ void config_init(Config *cfg);
 /* Clear configuration (free GMP resources) */
 void config_clear(Config *cfg);
 
+/* Parse a comma-separated event list ("psi,rho,mu_zero,ratio") into an
+ * OUTPUT_EVENT_* mask; false on an unknown name */
+bool config_parse_output_events(const char *text, unsigned *mask);
+
+/* True if any output_* field selects fewer rows than all */
+bool config_output_filtered(const Config *cfg);
+
 #endif /* TRTS_CONFIG_H */
@@ -331,21 +331,24 @@ bool config_load_from_file(Config *config, const char *path,
     config->koppa_trigger = (KoppaTrigger)enum_value;
     
     enum_value = (int)config->mt10_behavior;
-    apply_optional_enum(json, "mt10_behavior", MT10_FORCED_EMISSION_ONLY, MT10_FORCED_KOPPA, &enum_value);
-    config->mt10_behavior = (Mt10Behavior)enum_value;
+    apply_optional_enum(json, "mt10_behavior", MT10_NONE, MT10_BLOCK_PSI, &enum_value);
+    config->mt10_behavior = (MT10Behavior)enum_value;
     
     enum_value = (int)config->ratio_trigger_mode;
     apply_optional_enum(json, "ratio_trigger_mode", RATIO_TRIGGER_NONE, RATIO_TRIGGER_CUSTOM, &enum_value);
     config->ratio_trigger_mode = (RatioTriggerMode)enum_value;
     
     enum_value = (int)config->prime_target;
-    apply_optional_enum(json, "prime_target", PRIME_ON_MEMORY, PRIME_ON_NEW_UPSILON, &enum_value);
+    apply_optional_enum(json, "prime_target", PRIME_ON_MEMORY, PRIME_ON_KOPPA, &enum_value);
     config->prime_target = (PrimeTarget)enum_value;
     
+    enum_value = (int)config->output_format;
+    apply_optional_enum(json, "output_format", OUTPUT_FORMAT_CSV, OUTPUT_FORMAT_BINARY, &enum_value);
+    config->output_format = (OutputFormat)enum_value;
+    
     enum_value = (int)config->sign_flip_mode;
-    apply_optional_enum(json, "sign_flip_mode", SIGN_FLIP_NONE, SIGN_FLIP_ALTERNATE, &enum_value);
+    apply_optional_enum(json, "sign_flip_mode", SIGN_FLIP_NONE, SIGN_FLIP_ON_PSI, &enum_value);
     config->sign_flip_mode = (SignFlipMode)enum_value;
-    config->enable_sign_flip = (config->sign_flip_mode != SIGN_FLIP_NONE);
     
     /* Parse boolean flags */
     bool bool_value = false;
@@ -364,8 +367,10 @@ bool config_load_from_file(Config *config, const char *path,
     apply_optional_bool(json, "delta_koppa_offset", &config->enable_delta_koppa_offset);
     apply_optional_bool(json, "ratio_threshold_psi", &config->enable_ratio_threshold_psi);
     apply_optional_bool(json, "stack_depth_modes", &config->enable_stack_depth_modes);
-    apply_optional_bool(json, "epsilon_phi_triangle", &config->enable_epsilon_phi_triangle);
-    apply_optional_bool(json, "modular_wrap", &config->enable_modular_wrap);
+    apply_optional_bool(json, "epsilon_phi_triangle", &config->enable_epsilon_phi_swap);
+    apply_optional_bool(json, "epsilon_phi_swap", &config->enable_epsilon_phi_swap);
+    apply_optional_bool(json, "modular_wrap", &config->enable_beta_mod_koppa_wrap);
+    apply_optional_bool(json, "beta_mod_koppa_wrap", &config->enable_beta_mod_koppa_wrap);
     apply_optional_bool(json, "psi_strength_parameter", &config->enable_psi_strength_parameter);
     apply_optional_bool(json, "ratio_custom_range", &config->enable_ratio_custom_range);
     apply_optional_bool(json, "twin_prime_trigger", &config->enable_twin_prime_trigger);
@@ -374,6 +379,11 @@ bool config_load_from_file(Config *config, const char *path,
     apply_optional_bool(json, "ratio_snapshot_logging", &config->enable_ratio_snapshot_logging);
     apply_optional_bool(json, "feedback_oscillator", &config->enable_feedback_oscillator);
     apply_optional_bool(json, "fibonacci_gate", &config->enable_fibonacci_gate);
+    apply_optional_bool(json, "limb_arena", &config->enable_limb_arena);
+    apply_optional_bool(json, "cycle_detection", &config->enable_cycle_detection);
+    apply_optional_bool(json, "multimodular", &config->enable_multimodular_engine);
+    apply_optional_bool(json, "prime_too_large_is_prime", &config->prime_too_large_is_prime);
+    apply_optional_bool(json, "output_final_only", &config->output_final_only);
     
     /* Parse integer parameters */
     int ticks_value = 0;
@@ -381,6 +391,77 @@ bool config_load_from_file(Config *config, const char *path,
         config->ticks = (size_t)ticks_value;
     }
     
+    unsigned long threads_value = 0UL;
+    if (json_extract_unsigned(json, "multimodular_threads", &threads_value)) {
+        config->multimodular_threads = (unsigned)threads_value;
+    }
+    
+    unsigned long depth_value = 0UL;
+    if (json_extract_unsigned(json, "koppa_stack_depth", &depth_value)) {
+        if (depth_value == 0UL) {
+            write_error(error_buffer, error_capacity, "koppa_stack_depth must be at least 1");
+            free(buffer);
+            return false;
+        }
+        if (depth_value > KOPPA_STACK_MAX_DEPTH) {
+            write_error(error_buffer, error_capacity,
+                        "koppa_stack_depth must be at most 1048576");
+            free(buffer);
+            return false;
+        }
+        config->koppa_stack_depth = (size_t)depth_value;
+    }
+    
+    unsigned long every_value = 0UL;
+    if (json_extract_unsigned(json, "output_every", &every_value)) {
+        config->output_every = (size_t)every_value;
+    }
+    
+    unsigned long tick_value = 0UL;
+    if (json_extract_unsigned(json, "output_tick_from", &tick_value)) {
+        config->output_tick_from = (size_t)tick_value;
+    }
+    if (json_extract_unsigned(json, "output_tick_to", &tick_value)) {
+        config->output_tick_to = (size_t)tick_value;
+    }
+    
+    unsigned long queue_value = 0UL;
+    if (json_extract_unsigned(json, "output_queue_rows", &queue_value)) {
+        config->output_queue_rows = (size_t)queue_value;
+    }
+    
+    char events_text[64];
+    if (json_extract_string(json, "output_events", events_text, sizeof(events_text)) &&
+        !config_parse_output_events(events_text, &config->output_events)) {
+        write_error(error_buffer, error_capacity,
+                    "output_events must list psi, rho, mu_zero or ratio");
+        free(buffer);
+        return false;
+    }
+    
+    unsigned long reps_value = 0UL;
+    if (json_extract_unsigned(json, "prime_test_reps", &reps_value)) {
+        if (reps_value == 0UL || reps_value > 1000UL) {
+            write_error(error_buffer, error_capacity, "prime_test_reps must be between 1 and 1000");
+            free(buffer);
+            return false;
+        }
+        config->prime_test_reps = (int)reps_value;
+    }
+    
+    unsigned long bits_value = 0UL;
+    if (json_extract_unsigned(json, "prime_test_max_bits", &bits_value)) {
+        config->prime_test_max_bits = (size_t)bits_value;
+    }
+    
+    if (json_extract_unsigned(json, "pattern_threads", &threads_value)) {
+        config->pattern_threads = (unsigned)threads_value;
+    }
+    
+    if (json_extract_unsigned(json, "pattern_parallel_bits", &bits_value)) {
+        config->pattern_parallel_bits = (size_t)bits_value;
+    }
+    
     unsigned long wrap_value = 0UL;
     if (json_extract_unsigned(json, "koppa_wrap_threshold", &wrap_value)) {
         config->koppa_wrap_threshold = wrap_value;
@@ -0,0 +1,159 @@
+/* csv_writer.c - Buffered CSV Emitter Implementation
+ *
+ * The row buffer only grows; after the first few rows of a run it has
+ * reached the run's widest row and no further allocation happens. All
+ * buffers are malloc'd, never drawn from GMP.
+ */
+
+#include "csv_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Longest decimal long or size_t, with sign */
+#define CSV_DIGITS_MAX (sizeof(size_t) * 3 + 2)
+
+struct CsvWriter {
+    FILE *file;
+    char *block;                        /* setvbuf buffer, NULL for stdout */
+    char *row;
+    size_t len;
+    size_t cap;
+    bool row_started;
+    bool failed;
+};
+
+/* stdout outlives any writer, so its buffer must too */
+static char stdout_block[CSV_WRITER_BLOCK];
+
+/* Helper: abort on allocation failure, matching GMP's own policy */
+static void *checked(void *ptr) {
+    if (!ptr) {
+        abort();
+    }
+    return ptr;
+}
+
+static void row_reserve(CsvWriter *writer, size_t extra) {
+    if (writer->cap - writer->len >= extra) {
+        return;
+    }
+    size_t cap = writer->cap > 0 ? writer->cap : 256;
+    while (cap - writer->len < extra) {
+        cap *= 2;
+    }
+    writer->row = checked(realloc(writer->row, cap));
+    writer->cap = cap;
+}
+
+/* Helper: reserve room for a field of up to width bytes and its comma */
+static char *field_start(CsvWriter *writer, size_t width) {
+    row_reserve(writer, width + 1);
+    if (writer->row_started) {
+        writer->row[writer->len++] = ',';
+    }
+    writer->row_started = true;
+    return writer->row + writer->len;
+}
+
+/* Helper: decimal digits of value, written backwards from end */
+static char *format_unsigned(char *end, unsigned long long value) {
+    do {
+        *--end = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return end;
+}
+
+static void put_unsigned(CsvWriter *writer, unsigned long long value, bool negative) {
+    char digits[CSV_DIGITS_MAX];
+    char *end = digits + sizeof(digits);
+    char *begin = format_unsigned(end, value);
+    if (negative) {
+        *--begin = '-';
+    }
+    size_t n = (size_t)(end - begin);
+    memcpy(field_start(writer, n), begin, n);
+    writer->len += n;
+}
+
+static void put_signed(CsvWriter *writer, long long value) {
+    /* Negate in unsigned arithmetic so LLONG_MIN is exact */
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value
+                                             : (unsigned long long)value;
+    put_unsigned(writer, magnitude, value < 0);
+}
+
+CsvWriter *csv_writer_open(const char *path) {
+    FILE *file = path ? fopen(path, "w") : stdout;
+    if (!file) {
+        return NULL;
+    }
+
+    CsvWriter *writer = checked(calloc(1, sizeof(CsvWriter)));
+    writer->file = file;
+    char *block = stdout_block;
+    if (path) {
+        block = writer->block = checked(malloc(CSV_WRITER_BLOCK));
+    }
+    setvbuf(file, block, _IOFBF, CSV_WRITER_BLOCK);
+    return writer;
+}
+
+void csv_writer_text(CsvWriter *writer, const char *text) {
+    if (fputs(text, writer->file) == EOF) {
+        writer->failed = true;
+    }
+}
+
+void csv_put_mpz(CsvWriter *writer, mpz_srcptr value) {
+    if (mpz_fits_slong_p(value)) {
+        put_signed(writer, mpz_get_si(value));
+        return;
+    }
+    /* mpz_sizeinbase may exceed the digit count by one; sign and NUL */
+    size_t width = mpz_sizeinbase(value, 10) + 2;
+    char *out = field_start(writer, width);
+    mpz_get_str(out, 10, value);
+    writer->len += strlen(out);
+}
+
+void csv_put_size(CsvWriter *writer, size_t value) {
+    put_unsigned(writer, value, false);
+}
+
+void csv_put_int(CsvWriter *writer, int value) {
+    put_signed(writer, value);
+}
+
+void csv_put_char(CsvWriter *writer, char value) {
+    *field_start(writer, 1) = value;
+    writer->len++;
+}
+
+void csv_end_row(CsvWriter *writer) {
+    row_reserve(writer, 1);
+    writer->row[writer->len++] = '\n';
+    if (fwrite(writer->row, 1, writer->len, writer->file) != writer->len) {
+        writer->failed = true;
+    }
+    writer->len = 0;
+    writer->row_started = false;
+}
+
+bool csv_writer_close(CsvWriter *writer) {
+    if (!writer) {
+        return false;
+    }
+    bool ok = !writer->failed;
+    if (writer->file == stdout) {
+        ok = fflush(stdout) == 0 && ok;
+    } else {
+        ok = !ferror(writer->file) && ok;
+        ok = fclose(writer->file) == 0 && ok;
+    }
+    free(writer->block);
+    free(writer->row);
+    free(writer);
+    return ok;
+}
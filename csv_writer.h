@@ -0,0 +1,47 @@
+/* csv_writer.h - Buffered CSV Emitter
+ *
+ * Writes CSV rows without printf. Each row is assembled in one row buffer
+ * that grows on demand, so rows are never truncated however large the
+ * integers get:
+ * - Integers that fit in a long, and all size_t/int fields, go through a
+ *   hand-rolled decimal formatter.
+ * - Wider integers are converted by mpz_get_str straight into the row
+ *   buffer, sized from mpz_sizeinbase.
+ * Finished rows are handed to stdio in one fwrite, and the file itself
+ * gets one CSV_WRITER_BLOCK byte buffer (setvbuf).
+ *
+ * Fields are separated automatically: every csv_put_* after the first of
+ * a row is preceded by a comma.
+ */
+
+#ifndef TRTS_CSV_WRITER_H
+#define TRTS_CSV_WRITER_H
+
+#include <gmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CSV_WRITER_BLOCK (1u << 20)     /* stdio buffer per file */
+
+typedef struct CsvWriter CsvWriter;
+
+/* Create path for writing (NULL writes to stdout); NULL with errno set
+ * on failure */
+CsvWriter *csv_writer_open(const char *path);
+
+/* Append raw text (e.g. a header line) outside the row being built */
+void csv_writer_text(CsvWriter *writer, const char *text);
+
+/* Fields of the current row */
+void csv_put_mpz(CsvWriter *writer, mpz_srcptr value);
+void csv_put_size(CsvWriter *writer, size_t value);
+void csv_put_int(CsvWriter *writer, int value);
+void csv_put_char(CsvWriter *writer, char value);
+
+/* Terminate the current row and write it */
+void csv_end_row(CsvWriter *writer);
+
+/* Flush and close (stdout is flushed only); false if any write failed */
+bool csv_writer_close(CsvWriter *writer);
+
+#endif /* TRTS_CSV_WRITER_H */
@@ -40,4 +40,17 @@
  */
 bool engine_step(const Config *config, TRTS_State *state, int microtick);
 
+/* Resolve the track modes for a microtick from Config alone: default or
+ * dual modes, then the asymmetric cascade. Stack-depth and koppa-gate
+ * modulations depend on state and are applied by engine_step_resolved.
+ * Used by the simulation plan compiler to hoist mode selection out of
+ * the microtick loop. */
+void engine_resolve_modes(const Config *config, int microtick,
+                          EngineTrackMode *ups_mode, EngineTrackMode *beta_mode);
+
+/* engine_step with modes already resolved by engine_resolve_modes.
+ * engine_step(c, s, mt) is exactly engine_resolve_modes + this call. */
+bool engine_step_resolved(const Config *config, TRTS_State *state,
+                          EngineTrackMode ups_mode, EngineTrackMode beta_mode);
+
 #endif /* TRTS_ENGINE_H */
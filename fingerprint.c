@@ -0,0 +1,117 @@
+/* fingerprint.c - Rolling State Fingerprints
+ *
+ * Residues are floor remainders, so a value and its negation differ.
+ * Stack components are the first four entries in FIFO order (0/1 past a
+ * shallower stack); entries beyond the fourth only enter the digest.
+ */
+
+#include "fingerprint.h"
+#include <gmp.h>
+#include <limits.h>
+
+#define FINGERPRINT_P1 2147483647UL     /* 2^31 - 1 */
+#define FINGERPRINT_P2 2147483629UL     /* 2^31 - 19 */
+
+#define STACK_DEPTH(st) ((st)->koppa_stack_capacity)
+#define STACK_ENTRY(st, i) KOPPA_STACK_ENTRY(st, i)
+#define KOPPA_SAMPLE(st) state_koppa_sample(st)
+
+const char *const fingerprint_component_names[FINGERPRINT_COMPONENTS] = {
+    "upsilon_num", "upsilon_den",
+    "beta_num", "beta_den",
+    "koppa_num", "koppa_den",
+    "epsilon_num", "epsilon_den",
+    "phi_num", "phi_den",
+    "previous_upsilon_num", "previous_upsilon_den",
+    "previous_beta_num", "previous_beta_den",
+    "delta_upsilon_num", "delta_upsilon_den",
+    "delta_beta_num", "delta_beta_den",
+    "triangle_phi_over_epsilon_num", "triangle_phi_over_epsilon_den",
+    "triangle_prev_over_phi_num", "triangle_prev_over_phi_den",
+    "triangle_epsilon_over_prev_num", "triangle_epsilon_over_prev_den",
+    "koppa_stack0_num", "koppa_stack0_den",
+    "koppa_stack1_num", "koppa_stack1_den",
+    "koppa_stack2_num", "koppa_stack2_den",
+    "koppa_stack3_num", "koppa_stack3_den",
+    "koppa_sample_num", "koppa_sample_den"
+};
+
+/* Helper: both residues of z packed into one word */
+static uint64_t residue_pair(mpz_srcptr z) {
+#if ULONG_MAX >= 0xffffffffffffffffULL
+    unsigned long r = mpz_fdiv_ui(z, FINGERPRINT_P1 * FINGERPRINT_P2);
+    return (uint64_t)(r % FINGERPRINT_P1) << 32 | (uint64_t)(r % FINGERPRINT_P2);
+#else
+    return (uint64_t)mpz_fdiv_ui(z, FINGERPRINT_P1) << 32 | (uint64_t)mpz_fdiv_ui(z, FINGERPRINT_P2);
+#endif
+}
+
+/* Helper: splitmix64-style combine */
+static uint64_t fingerprint_mix(uint64_t h, uint64_t word) {
+    h ^= word + 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+void fingerprint_reset(StateFingerprint *fp) {
+    for (int i = 0; i < FINGERPRINT_COMPONENTS; ++i) {
+        fp->residue[i] = 0;
+    }
+    fp->scalars = 0;
+    fp->digest = 0;
+    fp->rolling = 0;
+    fp->count = 0;
+}
+
+void fingerprint_update(StateFingerprint *fp, const TRTS_State *st) {
+    size_t depth = STACK_DEPTH(st);
+    const Rational *regs[FINGERPRINT_COMPONENTS / 2] = {
+        &st->upsilon, &st->beta, &st->koppa, &st->epsilon, &st->phi,
+        &st->previous_upsilon, &st->previous_beta,
+        &st->delta_upsilon, &st->delta_beta,
+        &st->triangle_phi_over_epsilon, &st->triangle_prev_over_phi,
+        &st->triangle_epsilon_over_prev,
+        NULL, NULL, NULL, NULL,
+        KOPPA_SAMPLE(st)
+    };
+    for (size_t i = 0; i < 4 && i < depth; ++i) {
+        regs[12 + i] = STACK_ENTRY(st, i);
+    }
+    uint64_t h = 0;
+    for (int i = 0; i < FINGERPRINT_COMPONENTS / 2; ++i) {
+        if (regs[i]) {
+            fp->residue[2 * i] = residue_pair(regs[i]->num);
+            fp->residue[2 * i + 1] = residue_pair(regs[i]->den);
+        } else {
+            fp->residue[2 * i] = 0;                              /* 0/1 */
+            fp->residue[2 * i + 1] = (uint64_t)1 << 32 | 1;
+        }
+        h = fingerprint_mix(h, fp->residue[2 * i]);
+        h = fingerprint_mix(h, fp->residue[2 * i + 1]);
+    }
+    for (size_t i = 4; i < depth; ++i) {
+        h = fingerprint_mix(h, residue_pair(STACK_ENTRY(st, i)->num));
+        h = fingerprint_mix(h, residue_pair(STACK_ENTRY(st, i)->den));
+    }
+
+    fp->scalars = (uint64_t)st->koppa_stack_size << 48
+                | (uint64_t)(uint32_t)st->koppa_sample_index << 16
+                | (uint64_t)st->rho_pending
+                | (uint64_t)st->rho_latched << 1
+                | (uint64_t)st->psi_recent << 2
+                | (uint64_t)st->psi_triple_recent << 3
+                | (uint64_t)st->psi_strength_applied << 4
+                | (uint64_t)st->ratio_triggered_recent << 5
+                | (uint64_t)st->ratio_threshold_recent << 6
+                | (uint64_t)st->dual_engine_last_step << 7
+                | (uint64_t)st->sign_flip_polarity << 8;
+    h = fingerprint_mix(h, fp->scalars);
+
+    fp->digest = h;
+    fp->rolling = fingerprint_mix(fp->rolling, h);
+    fp->count++;
+}
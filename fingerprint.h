@@ -0,0 +1,48 @@
+/* fingerprint.h - Rolling State Fingerprints
+ *
+ * A fingerprint summarizes one microtick of a run: the residue of every
+ * register numerator and denominator modulo two fixed 31-bit primes, plus
+ * the koppa stack depth, the sample index and the flags. A rolling digest
+ * chains the per-microtick digests, so two runs agree on the rolling value
+ * at microtick n exactly when (up to hash collisions) they agree on every
+ * microtick up to n. That makes the first divergence between two streams
+ * findable by bisection.
+ *
+ * - Each component costs one mpz_fdiv_ui pass over its limbs (both primes
+ *   share one 62-bit modulus), about the price of one mpz_add of that
+ *   size; a small fraction of a step once operands are multiplied.
+ * - Streams from two builds are directly comparable, so a change can be
+ *   checked for raw-state identity against the build before it.
+ *
+ * Requires 64-bit unsigned long for the shared modulus; elsewhere each
+ * prime takes its own pass.
+ */
+
+#ifndef TRTS_FINGERPRINT_H
+#define TRTS_FINGERPRINT_H
+
+#include "state.h"
+#include <stdint.h>
+
+/* Register components covered: 17 registers, numerator and denominator */
+#define FINGERPRINT_COMPONENTS 34
+
+/* One microtick fingerprint plus the rolling digest of the run so far */
+typedef struct {
+    uint64_t residue[FINGERPRINT_COMPONENTS];   /* (x mod p1) << 32 | (x mod p2) */
+    uint64_t scalars;                           /* Stack depth, sample index, flags */
+    uint64_t digest;                            /* Hash of this microtick */
+    uint64_t rolling;                           /* Chained digests since reset */
+    size_t count;                               /* Microticks folded in */
+} StateFingerprint;
+
+/* Component names in residue order ("upsilon_num", ..., "koppa_sample_den") */
+extern const char *const fingerprint_component_names[FINGERPRINT_COMPONENTS];
+
+/* Start a new rolling chain */
+void fingerprint_reset(StateFingerprint *fp);
+
+/* Fingerprint st and fold it into the rolling digest */
+void fingerprint_update(StateFingerprint *fp, const TRTS_State *st);
+
+#endif /* TRTS_FINGERPRINT_H */
@@ -18,54 +18,51 @@ static void koppa_pop(TRTS_State *st) {
     rational_set(&st->koppa, &st->epsilon);
 }
 
-/* Koppa operation: ACCUMULATE sets κ = κ + ε */
-static void koppa_accumulate(TRTS_State *st) {
-    Rational tmp;
-    rational_init(&tmp);
-    rational_add(&tmp, &st->koppa, &st->epsilon);
-    rational_set(&st->koppa, &tmp);
-    rational_clear(&tmp);
+/* Koppa operation: ACCUMULATE sets κ = old + ε, where old is the value of
+ * κ before the operation (κ itself, or the stack slot it was pushed into;
+ * kernels are alias-safe) */
+static void koppa_accumulate(TRTS_State *st, const Rational *old) {
+    rational_add(&st->koppa, old, &st->epsilon);
 }
 
-/* Push value onto koppa stack (FIFO, max 4 entries) */
-static void koppa_stack_push(TRTS_State *st, const Rational *val) {
-    if (st->koppa_stack_size == 4) {
-        /* Stack full: shift left and replace last entry */
-        for (size_t i = 1; i < 4; ++i) {
-            rational_set(&st->koppa_stack[i - 1], &st->koppa_stack[i]);
-        }
-        rational_set(&st->koppa_stack[3], val);
+/* Push κ onto the koppa stack (FIFO ring). κ is swapped into the next
+ * slot, which is the oldest entry's slot when the ring is full, so no
+ * entry is copied. κ is left holding that slot's stale value and must be
+ * overwritten by the caller; returns the slot now holding the old κ. */
+static const Rational *koppa_stack_push(TRTS_State *st) {
+    Rational *slot;
+    if (st->koppa_stack_size == st->koppa_stack_capacity) {
+        /* Full: the oldest slot becomes the newest */
+        slot = &st->koppa_stack[st->koppa_stack_head];
+        st->koppa_stack_head = (st->koppa_stack_head + 1) % st->koppa_stack_capacity;
     } else {
-        /* Stack not full: push to next available slot */
-        rational_set(&st->koppa_stack[st->koppa_stack_size], val);
+        slot = KOPPA_STACK_ENTRY(st, st->koppa_stack_size);
         st->koppa_stack_size++;
     }
+    rational_swap(slot, &st->koppa);
+    return slot;
 }
 
-/* Update koppa_sample from the stack based on microtick */
+/* Point the koppa_sample view at the stack entry selected for this
+ * microtick, or at κ; no value is copied */
 static void koppa_update_sample(TRTS_State *st, int microtick, bool multi_level) {
+    st->koppa_sample_held = false;
     if (!multi_level || st->koppa_stack_size == 0) {
         /* If not multi-level or stack is empty, sample is always kappa */
-        rational_set(&st->koppa_sample, &st->koppa);
         return;
     }
 
-    /* Sample stack at MT 5 and MT 11 */
+    /* Sample stack at MT 5 and MT 11; indices are FIFO positions */
+    size_t depth = st->koppa_stack_capacity;
     int index = -1;
     if (microtick == 5 && st->koppa_stack_size >= 1) {
         index = 0; /* Sample oldest value (index 0) */
-    } else if (microtick == 11 && st->koppa_stack_size >= 3) {
-        index = 2; /* Sample second to newest value (index 2) */
+    } else if (microtick == 11 && depth >= 2 && st->koppa_stack_size >= depth - 1) {
+        index = (int)(depth - 2); /* Second to newest of a full stack (2 of 4) */
     }
 
-    if (index != -1) {
-        rational_set(&st->koppa_sample, &st->koppa_stack[index]);
-        st->koppa_sample_index = index;
-    } else {
-        /* Otherwise, sample is the current koppa */
-        rational_set(&st->koppa_sample, &st->koppa);
-        st->koppa_sample_index = -1;
-    }
+    /* Otherwise (-1), sample is the current koppa */
+    st->koppa_sample_index = index;
 }
 
 /* Update koppa according to configuration. */
@@ -106,9 +103,11 @@ void koppa_accrue(const Config *cfg, TRTS_State *st, bool psi_fired,
     
     /* 3. Perform koppa operation based on mode */
 
-    /* Push current koppa to stack if multi-level enabled */
+    /* Push current koppa to stack if multi-level enabled; every mode
+     * below overwrites κ, reading the pushed value from its slot */
+    const Rational *old_koppa = &st->koppa;
     if (cfg->multi_level_koppa) {
-        koppa_stack_push(st, &st->koppa);
+        old_koppa = koppa_stack_push(st);
     }
     
     switch (cfg->koppa_mode) {
@@ -119,22 +118,15 @@ void koppa_accrue(const Config *cfg, TRTS_State *st, bool psi_fired,
             koppa_pop(st);
             break;
         case KOPPA_MODE_ACCUMULATE:
-            koppa_accumulate(st);
+            koppa_accumulate(st, old_koppa);
             break;
     }
     
-    /* 4. Add (υ + β) to κ */
-    Rational tmp, sum;
-    rational_init(&tmp);
-    rational_init(&sum);
-    
-    rational_add(&tmp, &st->upsilon, &st->beta);
-    rational_add(&sum, &st->koppa, &tmp);
-    rational_set(&st->koppa, &sum);
-    
-    /* 5. Cleanup and sample update */
-    rational_clear(&tmp);
-    rational_clear(&sum);
+    /* 4. Add (υ + β) to κ: κ + (υ + β) has the same raw form as
+     * (υ + β) + κ, so a single fused kernel replaces both adds and the copy */
+    rational_add3(&st->koppa, &st->upsilon, &st->beta, &st->koppa);
+    STATE_TOUCH(st, STATE_GEN_KOPPA);
     
+    /* 5. Sample update */
     koppa_update_sample(st, microtick, cfg->multi_level_koppa);
 }
@@ -1,6 +1,6 @@
 /* koppa.h - TRTS Koppa (κ) Operations
  *
- * Manages the koppa register and 4-level stack.
+ * Manages the koppa register and multi-level stack.
  * Blueprint reference: koppa.h/koppa.c from Section 1.
  *
  * Koppa operations:
@@ -8,8 +8,9 @@
  * - POP: κ ← ε
  * - ACCUMULATE: κ ← κ + ε
  *
- * Multi-level mode maintains a 4-entry FIFO stack and samples
- * specific stack entries at microticks 5 and 11.
+ * Multi-level mode maintains a FIFO ring of Config.koppa_stack_depth
+ * entries (default 4) and samples specific stack entries at microticks
+ * 5 and 11.
  */
 
 #ifndef TRTS_KOPPA_H
@@ -32,7 +33,7 @@
  * - Determines if trigger condition is met based on koppa_trigger
  * - If triggered, pushes to stack (if multi-level) and performs operation
  * - Adds (υ + β) to κ after operation
- * - Updates koppa_sample from stack at specific microticks
+ * - Points the koppa_sample view at the stack at specific microticks
  * - Maintains psi_recent flag for KOPPA_ON_MU_AFTER_PSI mode
  */
 void koppa_accrue(const Config *cfg, TRTS_State *st, bool psi_fired, 
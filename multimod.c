@@ -0,0 +1,845 @@
+/* multimod.c - Multi-Modular (CRT) Final-State Engine Implementation
+ *
+ * One interpreter serves two rings: residues modulo a prime p, and, with
+ * p == 0, fixed-point upper bounds on log2|x| (mul adds logs, add takes the
+ * larger plus log2(1 + 2^-gap), rounded up). Unlike bit counts these stay
+ * exact for 1, so integer denominators do not drift across millions of
+ * products. The bound pass also runs the control flow, which is identical
+ * in every lane, so the final flags and stack depth are taken from it.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "multimod.h"
+#include "rational.h"
+#include <gmp.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#if defined(__SIZEOF_INT128__) && ULONG_MAX >= 0xffffffffffffffffUL
+#define MULTIMOD_AVAILABLE 1
+__extension__ typedef unsigned __int128 mm_wide;
+#else
+#define MULTIMOD_AVAILABLE 0
+#endif
+
+/* Registers carried by a lane, in TRTS_State order (the koppa sample is a
+ * view; lanes only track its index) */
+enum {
+    MM_UPSILON, MM_BETA, MM_KOPPA, MM_EPSILON, MM_PHI,
+    MM_PREV_UPSILON, MM_PREV_BETA, MM_DELTA_UPSILON, MM_DELTA_BETA,
+    MM_TRI_PHI_EPSILON, MM_TRI_PREV_PHI, MM_TRI_EPSILON_PREV,
+    MM_STACK0, MM_STACK1, MM_STACK2, MM_STACK3,
+    MM_REG_COUNT
+};
+
+#define MM_COMPONENTS    (2 * MM_REG_COUNT)
+#define MM_PRIME_BITS    61                        /* Every prime exceeds 2^61 */
+#define MM_BITS_CAP      ((uint64_t)1 << 32)       /* Largest supported bound */
+#define MM_LOG_ONE       ((uint64_t)1 << 20)       /* Fixed-point unit of one bit */
+#define MM_CHUNK_LANES   16                        /* Lanes claimed per grab */
+
+#if MULTIMOD_AVAILABLE
+
+/* Helper: TRTS_State registers in lane order */
+static void state_lane_registers(TRTS_State *st, Rational *regs[MM_REG_COUNT]) {
+    regs[MM_UPSILON] = &st->upsilon;
+    regs[MM_BETA] = &st->beta;
+    regs[MM_KOPPA] = &st->koppa;
+    regs[MM_EPSILON] = &st->epsilon;
+    regs[MM_PHI] = &st->phi;
+    regs[MM_PREV_UPSILON] = &st->previous_upsilon;
+    regs[MM_PREV_BETA] = &st->previous_beta;
+    regs[MM_DELTA_UPSILON] = &st->delta_upsilon;
+    regs[MM_DELTA_BETA] = &st->delta_beta;
+    regs[MM_TRI_PHI_EPSILON] = &st->triangle_phi_over_epsilon;
+    regs[MM_TRI_PREV_PHI] = &st->triangle_prev_over_phi;
+    regs[MM_TRI_EPSILON_PREV] = &st->triangle_epsilon_over_prev;
+    for (int i = 0; i < 4; ++i) {
+        regs[MM_STACK0 + i] = KOPPA_STACK_ENTRY(st, i);
+    }
+}
+
+static bool positive_seed(const Rational *q) {
+    return mpz_sgn(q->num) > 0 && mpz_sgn(q->den) > 0;
+}
+
+bool multimod_admissible(const Config *config) {
+    bool delta_add = !config->dual_track_mode &&
+                     config->engine_mode == ENGINE_MODE_DELTA_ADD;
+    return !delta_add &&
+           !config->enable_psi_strength_parameter &&
+           !config->enable_conditional_triple_psi &&
+           !config->enable_koppa_gated_engine &&
+           !config->enable_beta_mod_koppa_wrap &&
+           !config->enable_epsilon_phi_swap &&
+           !config->enable_delta_cross_propagation &&
+           config->sign_flip_mode == SIGN_FLIP_NONE &&
+           config->koppa_mode != KOPPA_MODE_DUMP &&
+           config->koppa_stack_depth == 4 &&
+           positive_seed(&config->initial_upsilon) &&
+           positive_seed(&config->initial_beta) &&
+           positive_seed(&config->initial_koppa);
+}
+
+/* ========================================
+   LANE ARITHMETIC
+   ======================================== */
+
+typedef struct {
+    uint64_t num;
+    uint64_t den;
+} ModRational;
+
+/* Log ring encoding: 0 for a zero value, otherwise 1 + ceil(log2|x| in
+ * MM_LOG_ONE units). Results saturate at MM_BITS_CAP bits. */
+static uint64_t log_cap(uint64_t x) {
+    return (x > MM_BITS_CAP * MM_LOG_ONE) ? MM_BITS_CAP * MM_LOG_ONE : x;
+}
+
+static uint64_t log_of(mpz_srcptr z) {
+    if (mpz_sgn(z) == 0) {
+        return 0;
+    }
+    if (mpz_cmpabs_ui(z, 1UL) == 0) {
+        return 1;
+    }
+    size_t bits = mpz_sizeinbase(z, 2);
+    if (bits > 53) {
+        return log_cap(1 + (uint64_t)bits * MM_LOG_ONE);
+    }
+    double magnitude = fabs(mpz_get_d(z));
+    return 2 + (uint64_t)ceil(log2(magnitude) * (double)MM_LOG_ONE);
+}
+
+/* |x ± y| <= 2^hi * (1 + 2^-(hi - lo)); one extra unit covers rounding */
+static uint64_t log_add(uint64_t x, uint64_t y) {
+    if (x == 0 || y == 0) {
+        return x + y;
+    }
+    uint64_t hi = (x > y) ? x : y;
+    uint64_t lo = (x > y) ? y : x;
+    double gap = (double)(hi - lo) / (double)MM_LOG_ONE;
+    double carry = log2(1.0 + exp2(-gap)) * (double)MM_LOG_ONE;
+    return log_cap(hi + (uint64_t)ceil(carry) + 1);
+}
+
+static uint64_t log_mul(uint64_t x, uint64_t y) {
+    if (x == 0 || y == 0) {
+        return 0;
+    }
+    return log_cap(x + y - 1);
+}
+
+/* Arithmetic context of a lane: a prime with residues kept in Montgomery
+ * form (R = 2^64), or the log ring when p == 0. Lanes only add, subtract
+ * and multiply, so the Montgomery factor cancels on the way out. */
+typedef struct {
+    uint64_t p;
+    uint64_t p_neg_inv;             /* -p^-1 mod 2^64 */
+    uint64_t r2;                    /* R^2 mod p */
+} ModRing;
+
+static void ring_init(ModRing *ring, uint64_t p) {
+    ring->p = p;
+    ring->p_neg_inv = 0;
+    ring->r2 = 0;
+    if (p == 0) {
+        return;
+    }
+    uint64_t inv = p;               /* p * p = 1 mod 8; each step doubles the bits */
+    for (int i = 0; i < 5; ++i) {
+        inv *= 2 - p * inv;
+    }
+    ring->p_neg_inv = (uint64_t)0 - inv;
+    uint64_t r = (uint64_t)(((mm_wide)1 << 64) % p);
+    ring->r2 = (uint64_t)((mm_wide)r * r % p);
+}
+
+/* x * y / R mod p for x, y < p < 2^62 */
+static uint64_t mont_mul(const ModRing *ring, uint64_t x, uint64_t y) {
+    mm_wide t = (mm_wide)x * y;
+    uint64_t m = (uint64_t)t * ring->p_neg_inv;
+    uint64_t u = (uint64_t)((t + (mm_wide)m * ring->p) >> 64);
+    return u >= ring->p ? u - ring->p : u;
+}
+
+static uint64_t ring_from_mpz(const ModRing *ring, mpz_srcptr z) {
+    if (ring->p == 0) {
+        return log_of(z);
+    }
+    return mont_mul(ring, mpz_fdiv_ui(z, ring->p), ring->r2);
+}
+
+static uint64_t ring_residue(const ModRing *ring, uint64_t x) {
+    return mont_mul(ring, x, 1);
+}
+
+static uint64_t ring_add(const ModRing *ring, uint64_t x, uint64_t y) {
+    if (ring->p == 0) {
+        return log_add(x, y);
+    }
+    uint64_t s = x + y;               /* x, y < p < 2^62: no overflow */
+    return s >= ring->p ? s - ring->p : s;
+}
+
+static uint64_t ring_sub(const ModRing *ring, uint64_t x, uint64_t y) {
+    if (ring->p == 0) {
+        return log_add(x, y);
+    }
+    return x >= y ? x - y : x + (ring->p - y);
+}
+
+static uint64_t ring_mul(const ModRing *ring, uint64_t x, uint64_t y) {
+    if (ring->p == 0) {
+        return log_mul(x, y);
+    }
+    return mont_mul(ring, x, y);
+}
+
+/* Raw a + b = (a.num * b.den + b.num * a.den) / (a.den * b.den) */
+static ModRational mr_add(const ModRing *ring, ModRational a, ModRational b) {
+    ModRational r;
+    r.num = ring_add(ring, ring_mul(ring, a.num, b.den), ring_mul(ring, b.num, a.den));
+    r.den = ring_mul(ring, a.den, b.den);
+    return r;
+}
+
+static ModRational mr_sub(const ModRing *ring, ModRational a, ModRational b) {
+    ModRational r;
+    r.num = ring_sub(ring, ring_mul(ring, a.num, b.den), ring_mul(ring, b.num, a.den));
+    r.den = ring_mul(ring, a.den, b.den);
+    return r;
+}
+
+/* Track formulas, same raw component order as the fused rational kernels */
+static ModRational mr_track(const ModRing *ring, EngineTrackMode mode, ModRational current,
+                            ModRational counterpart, ModRational koppa) {
+    ModRational s;
+    ModRational r;
+    switch (mode) {
+    case ENGINE_TRACK_MULTI:
+        s = mr_add(ring, counterpart, koppa);
+        r.num = ring_mul(ring, current.num, s.num);
+        r.den = ring_mul(ring, current.den, s.den);
+        return r;
+    case ENGINE_TRACK_SLIDE:
+        s = mr_add(ring, current, counterpart);
+        r.num = ring_mul(ring, s.num, koppa.den);
+        r.den = ring_mul(ring, s.den, koppa.num);
+        return r;
+    case ENGINE_TRACK_ADD:
+    default:
+        return mr_add(ring, mr_add(ring, current, counterpart), koppa);
+    }
+}
+
+/* ========================================
+   LANE INTERPRETER
+   ======================================== */
+
+typedef struct {
+    ModRing ring;                   /* Prime modulus, p == 0 for the bound pass */
+    ModRational reg[MM_REG_COUNT];
+    size_t stack_size;
+    int sample_index;
+    bool rho_pending;
+    bool psi_recent;
+    bool psi_triple_recent;
+    bool dual_engine_last_step;
+} ModLane;
+
+static void lane_load(ModLane *lane, uint64_t p, TRTS_State *start) {
+    Rational *regs[MM_REG_COUNT];
+    state_lane_registers(start, regs);
+    ring_init(&lane->ring, p);
+    for (int i = 0; i < MM_REG_COUNT; ++i) {
+        lane->reg[i].num = ring_from_mpz(&lane->ring, regs[i]->num);
+        lane->reg[i].den = ring_from_mpz(&lane->ring, regs[i]->den);
+    }
+    lane->stack_size = start->koppa_stack_size;
+    lane->sample_index = start->koppa_sample_index;
+    lane->rho_pending = start->rho_pending;
+    lane->psi_recent = start->psi_recent;
+    lane->psi_triple_recent = start->psi_triple_recent;
+    lane->dual_engine_last_step = start->dual_engine_last_step;
+}
+
+/* Mirrors apply_stack_depth_mode */
+static EngineTrackMode lane_stack_mode(const Config *config, const ModLane *lane,
+                                       EngineTrackMode mode) {
+    if (!config->enable_stack_depth_modes) {
+        return mode;
+    }
+    if (lane->stack_size <= 1) {
+        return ENGINE_TRACK_ADD;
+    }
+    if (lane->stack_size <= 3) {
+        return ENGINE_TRACK_MULTI;
+    }
+    return (lane->stack_size == 4) ? ENGINE_TRACK_SLIDE : ENGINE_TRACK_ADD;
+}
+
+/* Mirrors engine_step_resolved; the pre-step deltas are overwritten by the
+ * commit, so only the post-commit ones are computed */
+static void lane_engine(const Config *config, ModLane *lane,
+                        EngineTrackMode ups_mode, EngineTrackMode beta_mode) {
+    const ModRing *ring = &lane->ring;
+    ModRational *r = lane->reg;
+    ups_mode = lane_stack_mode(config, lane, ups_mode);
+    beta_mode = lane_stack_mode(config, lane, beta_mode);
+
+    ModRational new_upsilon = mr_track(ring, ups_mode, r[MM_UPSILON], r[MM_BETA], r[MM_KOPPA]);
+    ModRational new_beta = mr_track(ring, beta_mode, r[MM_BETA], r[MM_UPSILON], r[MM_KOPPA]);
+
+    r[MM_PREV_UPSILON] = r[MM_UPSILON];
+    r[MM_UPSILON] = new_upsilon;
+    r[MM_PREV_BETA] = r[MM_BETA];
+    r[MM_BETA] = new_beta;
+    lane->dual_engine_last_step = config->dual_track_mode;
+    r[MM_DELTA_UPSILON] = mr_sub(ring, r[MM_UPSILON], r[MM_PREV_UPSILON]);
+    r[MM_DELTA_BETA] = mr_sub(ring, r[MM_BETA], r[MM_PREV_BETA]);
+}
+
+/* Mirrors psi_transform without strength or conditional triple; the
+ * positive registers make every cross product nonzero */
+static bool lane_psi(const Config *config, ModLane *lane) {
+    const ModRing *ring = &lane->ring;
+    ModRational *r = lane->reg;
+    lane->psi_recent = false;
+    lane->psi_triple_recent = false;
+    if (!lane->rho_pending && config->psi_mode != PSI_MODE_MSTEP) {
+        return false;
+    }
+
+    if (config->triple_psi_mode) {
+        uint64_t bk_num = ring_mul(ring, r[MM_BETA].num, r[MM_KOPPA].den);
+        uint64_t bk_den = ring_mul(ring, r[MM_BETA].den, r[MM_KOPPA].num);
+        uint64_t ku_num = ring_mul(ring, r[MM_KOPPA].num, r[MM_UPSILON].den);
+        uint64_t ku_den = ring_mul(ring, r[MM_KOPPA].den, r[MM_UPSILON].num);
+        r[MM_KOPPA].num = bk_den;
+        r[MM_KOPPA].den = bk_num;
+        r[MM_UPSILON].num = bk_num;
+        r[MM_UPSILON].den = bk_den;
+        r[MM_BETA].num = ku_num;
+        r[MM_BETA].den = ku_den;
+        lane->psi_triple_recent = true;
+    } else {
+        uint64_t pn = ring_mul(ring, r[MM_BETA].num, r[MM_UPSILON].den);
+        uint64_t qn = ring_mul(ring, r[MM_BETA].den, r[MM_UPSILON].num);
+        r[MM_BETA].num = qn;
+        r[MM_BETA].den = pn;
+        r[MM_UPSILON].num = pn;
+        r[MM_UPSILON].den = qn;
+    }
+    lane->psi_recent = true;
+    lane->rho_pending = false;
+    return true;
+}
+
+/* Mirrors koppa_update_sample */
+static void lane_sample(const Config *config, ModLane *lane, int microtick) {
+    if (!config->multi_level_koppa || lane->stack_size == 0) {
+        return;
+    }
+    int index = -1;
+    if (microtick == 5 && lane->stack_size >= 1) {
+        index = 0;
+    } else if (microtick == 11 && lane->stack_size >= 3) {
+        index = 2;
+    }
+    lane->sample_index = index;
+}
+
+/* Mirrors koppa_accrue (DUMP is not admissible) */
+static void lane_accrue(const Config *config, ModLane *lane, bool psi_fired,
+                        bool is_memory_step, int microtick) {
+    const ModRing *ring = &lane->ring;
+    ModRational *r = lane->reg;
+    bool trigger = false;
+    switch (config->koppa_trigger) {
+    case KOPPA_ON_PSI:
+        trigger = psi_fired;
+        break;
+    case KOPPA_ON_MSTEP:
+        trigger = is_memory_step;
+        break;
+    case KOPPA_ON_ALL_MU:
+        trigger = true;
+        break;
+    case KOPPA_ON_MU_AFTER_PSI:
+        trigger = lane->psi_recent;
+        break;
+    }
+    lane->psi_recent = psi_fired ||
+                       (config->koppa_trigger == KOPPA_ON_MU_AFTER_PSI && !is_memory_step);
+
+    if (trigger) {
+        if (config->multi_level_koppa) {
+            if (lane->stack_size == 4) {
+                for (int i = 1; i < 4; ++i) {
+                    r[MM_STACK0 + i - 1] = r[MM_STACK0 + i];
+                }
+                r[MM_STACK3] = r[MM_KOPPA];
+            } else {
+                r[MM_STACK0 + lane->stack_size] = r[MM_KOPPA];
+                lane->stack_size++;
+            }
+        }
+        if (config->koppa_mode == KOPPA_MODE_POP) {
+            r[MM_KOPPA] = r[MM_EPSILON];
+        } else {
+            r[MM_KOPPA] = mr_add(ring, r[MM_KOPPA], r[MM_EPSILON]);
+        }
+        r[MM_KOPPA] = mr_add(ring, mr_add(ring, r[MM_UPSILON], r[MM_BETA]), r[MM_KOPPA]);
+    }
+    lane_sample(config, lane, microtick);
+}
+
+/* Mirrors stack_allows_psi and should_fire_psi on a memory step */
+static bool lane_psi_requested(const Config *config, const ModLane *lane, bool *allow_stack) {
+    *allow_stack = !config->enable_stack_depth_modes ||
+                   lane->stack_size == 2 || lane->stack_size == 4;
+    if (!*allow_stack) {
+        return false;
+    }
+    switch (config->psi_mode) {
+    case PSI_MODE_MSTEP:
+    case PSI_MODE_MSTEP_RHO:
+        return true;
+    case PSI_MODE_RHO_ONLY:
+        return lane->rho_pending;
+    case PSI_MODE_INHIBIT_RHO:
+        return !lane->rho_pending;
+    }
+    return false;
+}
+
+/* One tick: each microtick clears its flags as run_tick does, then runs
+ * the ops of its slot */
+static void lane_tick(const Config *config, const MultimodProgram *prog, ModLane *lane) {
+    for (int microtick = 1; microtick <= 11; ++microtick) {
+        const MultimodSlot *slot = &prog->slot[microtick - 1];
+        bool allow_stack = true;
+        bool request = false;
+        bool fired = false;
+        lane->psi_triple_recent = false;
+        lane->dual_engine_last_step = false;
+        lane->sample_index = -1;
+
+        for (int i = 0; i < slot->op_count; ++i) {
+            switch (slot->ops[i]) {
+            case MULTIMOD_OP_ENGINE:
+                lane->reg[MM_EPSILON] = lane->reg[MM_UPSILON];
+                lane_engine(config, lane, slot->ups_mode, slot->beta_mode);
+                break;
+            case MULTIMOD_OP_FORCED_PSI:
+                lane->rho_pending = true;
+                break;
+            case MULTIMOD_OP_REQUEST_PSI:
+                request = lane_psi_requested(config, lane, &allow_stack);
+                break;
+            case MULTIMOD_OP_REQUEST_PSI_ALWAYS:
+                request = true;
+                break;
+            case MULTIMOD_OP_PSI_AND_ACCRUE:
+                if (request && allow_stack) {
+                    fired = lane_psi(config, lane);
+                } else {
+                    lane->psi_recent = false;
+                }
+                lane_accrue(config, lane, fired, true, microtick);
+                break;
+            case MULTIMOD_OP_RESET_ACCRUE:
+                lane_accrue(config, lane, false, false, microtick);
+                lane->psi_recent = false;
+                break;
+            }
+        }
+    }
+}
+
+/* ========================================
+   WORKERS
+   ======================================== */
+
+typedef struct {
+    const Config *config;
+    const MultimodProgram *prog;
+    size_t ticks;
+    TRTS_State *start;              /* Reset state, read only */
+    const uint64_t *primes;
+    uint64_t *residues;             /* lane_count x MM_COMPONENTS */
+    size_t lane_count;
+    size_t next_lane;               /* Shared cursor (atomic) */
+} MultimodJob;
+
+static void *lane_worker(void *arg) {
+    MultimodJob *job = arg;
+    for (;;) {
+        size_t lo = __atomic_fetch_add(&job->next_lane, MM_CHUNK_LANES, __ATOMIC_RELAXED);
+        if (lo >= job->lane_count) {
+            break;
+        }
+        size_t hi = lo + MM_CHUNK_LANES;
+        if (hi > job->lane_count) {
+            hi = job->lane_count;
+        }
+        for (size_t i = lo; i < hi; ++i) {
+            ModLane lane;
+            lane_load(&lane, job->primes[i], job->start);
+            for (size_t tick = 1; tick <= job->ticks; ++tick) {
+                lane_tick(job->config, job->prog, &lane);
+            }
+            uint64_t *out = &job->residues[i * MM_COMPONENTS];
+            for (int r = 0; r < MM_REG_COUNT; ++r) {
+                out[2 * r] = ring_residue(&lane.ring, lane.reg[r].num);
+                out[2 * r + 1] = ring_residue(&lane.ring, lane.reg[r].den);
+            }
+        }
+    }
+    return NULL;
+}
+
+static unsigned worker_count(const Config *config, size_t jobs) {
+    unsigned threads = config->multimodular_threads;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (online > 0) ? (unsigned)online : 1U;
+    }
+    if ((size_t)threads > jobs) {
+        threads = (unsigned)jobs;
+    }
+    return threads;
+}
+
+/* Run worker on up to threads threads until the job's cursor is exhausted;
+ * falls back to the calling thread if no thread can start */
+static unsigned run_workers(void *(*worker)(void *), void *job, unsigned threads) {
+    pthread_t *ids = malloc(threads * sizeof(pthread_t));
+    unsigned started = 0;
+    if (ids) {
+        while (started < threads &&
+               pthread_create(&ids[started], NULL, worker, job) == 0) {
+            ++started;
+        }
+    }
+    if (started == 0) {
+        worker(job);
+    }
+    for (unsigned i = 0; i < started; ++i) {
+        pthread_join(ids[i], NULL);
+    }
+    free(ids);
+    return started ? started : 1U;
+}
+
+/* ========================================
+   RECONSTRUCTION
+   ======================================== */
+
+/* Helper: abort on allocation failure, matching GMP's own policy */
+static void *checked(void *ptr) {
+    if (!ptr) {
+        abort();
+    }
+    return ptr;
+}
+
+/* Product tree over the primes: level 0 holds the primes, each node of
+ * level l + 1 the product of two adjacent nodes of level l (an odd last
+ * node moves up unchanged). The root is the modulus M. */
+#define MM_MAX_LEVELS 64
+
+typedef struct {
+    size_t levels;
+    size_t width[MM_MAX_LEVELS];
+    mpz_t *node[MM_MAX_LEVELS];
+} ProductTree;
+
+static void tree_build(ProductTree *tree, const uint64_t *primes, size_t count) {
+    tree->levels = 1;
+    tree->width[0] = count;
+    tree->node[0] = checked(malloc(count * sizeof(mpz_t)));
+    for (size_t i = 0; i < count; ++i) {
+        mpz_init_set_ui(tree->node[0][i], primes[i]);
+    }
+    while (tree->width[tree->levels - 1] > 1) {
+        size_t l = tree->levels++;
+        size_t below = tree->width[l - 1];
+        tree->width[l] = (below + 1) / 2;
+        tree->node[l] = checked(malloc(tree->width[l] * sizeof(mpz_t)));
+        for (size_t i = 0; i < tree->width[l]; ++i) {
+            mpz_init_set(tree->node[l][i], tree->node[l - 1][2 * i]);
+            if (2 * i + 1 < below) {
+                mpz_mul(tree->node[l][i], tree->node[l][i], tree->node[l - 1][2 * i + 1]);
+            }
+        }
+    }
+}
+
+static void tree_clear(ProductTree *tree) {
+    for (size_t l = 0; l < tree->levels; ++l) {
+        for (size_t i = 0; i < tree->width[l]; ++i) {
+            mpz_clear(tree->node[l][i]);
+        }
+        free(tree->node[l]);
+    }
+}
+
+static mpz_srcptr tree_root(const ProductTree *tree) {
+    return tree->node[tree->levels - 1][0];
+}
+
+/* Leaf weights w_i = ((M / m_i) mod m_i)^-1 mod m_i. The cofactors
+ * c_v = (M / N_v) mod N_v are pushed down the tree: a child L with sibling
+ * R gets c_L = c_v * N_R mod N_L. Shared by all components. */
+static void tree_weights(const ProductTree *tree, uint64_t *weight) {
+    mpz_t *cofactor = checked(malloc(sizeof(mpz_t)));
+    mpz_init_set_ui(cofactor[0], 1UL);
+    mpz_t sibling;
+    mpz_init(sibling);
+    for (size_t l = tree->levels - 1; l > 0; --l) {
+        size_t width = tree->width[l - 1];
+        mpz_t *child = checked(malloc(width * sizeof(mpz_t)));
+        for (size_t i = 0; i < width; ++i) {
+            mpz_init(child[i]);
+            mpz_mod(child[i], cofactor[i / 2], tree->node[l - 1][i]);
+            if ((i ^ 1) < width) {
+                mpz_mod(sibling, tree->node[l - 1][i ^ 1], tree->node[l - 1][i]);
+                mpz_mul(child[i], child[i], sibling);
+                mpz_mod(child[i], child[i], tree->node[l - 1][i]);
+            }
+        }
+        for (size_t i = 0; i < tree->width[l]; ++i) {
+            mpz_clear(cofactor[i]);
+        }
+        free(cofactor);
+        cofactor = child;
+    }
+    for (size_t i = 0; i < tree->width[0]; ++i) {
+        mpz_invert(cofactor[i], cofactor[i], tree->node[0][i]);
+        weight[i] = mpz_get_ui(cofactor[i]);
+        mpz_clear(cofactor[i]);
+    }
+    free(cofactor);
+    mpz_clear(sibling);
+}
+
+typedef struct {
+    const ProductTree *tree;
+    const uint64_t *primes;
+    const uint64_t *weight;
+    const uint64_t *residues;
+    mpz_t *value;                   /* MM_COMPONENTS results */
+    size_t next_component;          /* Shared cursor (atomic) */
+} CrtJob;
+
+/* x = sum_i (r_i * w_i mod m_i) * (M / m_i), built bottom-up as
+ * x_v = x_L * N_R + x_R * N_L and reduced modulo M at the root */
+static void crt_component(const CrtJob *job, int component) {
+    const ProductTree *tree = job->tree;
+    size_t count = tree->width[0];
+    /* Components that are the same small value in every lane (0/0 slots,
+     * unit denominators) need no reconstruction */
+    uint64_t first = job->residues[component];
+    size_t same = 1;
+    while (same < count && job->residues[same * MM_COMPONENTS + component] == first) {
+        ++same;
+    }
+    if (same == count) {
+        mpz_set_ui(job->value[component], first);
+        return;
+    }
+    mpz_t *x = checked(malloc(count * sizeof(mpz_t)));
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t r = job->residues[i * MM_COMPONENTS + component];
+        mpz_init_set_ui(x[i], (uint64_t)((mm_wide)r * job->weight[i] % job->primes[i]));
+    }
+    /* Level l + 1 is compacted into x[0 .. width); consumed entries are
+     * re-initialized so their limbs are released early */
+    for (size_t l = 0; l + 1 < tree->levels; ++l) {
+        size_t width = tree->width[l];
+        for (size_t i = 0; 2 * i < width; ++i) {
+            if (2 * i + 1 < width) {
+                mpz_mul(x[2 * i], x[2 * i], tree->node[l][2 * i + 1]);
+                mpz_addmul(x[2 * i], x[2 * i + 1], tree->node[l][2 * i]);
+                mpz_clear(x[2 * i + 1]);
+                mpz_init(x[2 * i + 1]);
+            }
+            if (i > 0) {
+                mpz_swap(x[i], x[2 * i]);
+                mpz_clear(x[2 * i]);
+                mpz_init(x[2 * i]);
+            }
+        }
+    }
+    mpz_mod(job->value[component], x[0], tree_root(tree));
+    for (size_t i = 0; i < count; ++i) {
+        mpz_clear(x[i]);
+    }
+    free(x);
+}
+
+static void *crt_worker(void *arg) {
+    CrtJob *job = arg;
+    for (;;) {
+        size_t c = __atomic_fetch_add(&job->next_component, 1, __ATOMIC_RELAXED);
+        if (c >= MM_COMPONENTS) {
+            break;
+        }
+        crt_component(job, (int)c);
+    }
+    return NULL;
+}
+
+/* Helper: the first count primes above 2^61 */
+static void generate_primes(uint64_t *primes, size_t count) {
+    mpz_t candidate;
+    mpz_init(candidate);
+    mpz_setbit(candidate, MM_PRIME_BITS);
+    for (size_t i = 0; i < count; ++i) {
+        mpz_nextprime(candidate, candidate);
+        primes[i] = mpz_get_ui(candidate);
+    }
+    mpz_clear(candidate);
+}
+
+bool multimod_final(const Config *config, const MultimodProgram *program,
+                    size_t ticks, TRTS_State *state, MultimodStats *stats) {
+    if (!multimod_admissible(config)) {
+        return false;
+    }
+
+    TRTS_State start;
+    state_init(&start);
+    state_reset(&start, config);
+
+    /* Bound pass: bit sizes and the (value-independent) control flow */
+    ModLane bound;
+    lane_load(&bound, 0, &start);
+    for (size_t tick = 1; tick <= ticks; ++tick) {
+        lane_tick(config, program, &bound);
+    }
+    uint64_t bound_log = 0;
+    for (int r = 0; r < MM_REG_COUNT; ++r) {
+        if (bound.reg[r].num > bound_log) {
+            bound_log = bound.reg[r].num;
+        }
+        if (bound.reg[r].den > bound_log) {
+            bound_log = bound.reg[r].den;
+        }
+    }
+    /* Every component satisfies |x| <= 2^bound_bits */
+    uint64_t bound_bits = (bound_log > 0) ? (bound_log - 1 + MM_LOG_ONE - 1) / MM_LOG_ONE : 0;
+    if (bound_bits >= MM_BITS_CAP) {
+        state_clear(&start);
+        return false;
+    }
+
+    /* Symmetric range: the prime product must exceed 2^(bound + 1) */
+    size_t lane_count = (size_t)(bound_bits + 1) / MM_PRIME_BITS + 1;
+    uint64_t *primes = malloc(lane_count * sizeof(uint64_t));
+    uint64_t *residues = malloc(lane_count * MM_COMPONENTS * sizeof(uint64_t));
+    if (!primes || !residues) {
+        free(primes);
+        free(residues);
+        state_clear(&start);
+        return false;
+    }
+    generate_primes(primes, lane_count);
+
+    MultimodJob job = {config, program, ticks, &start, primes, residues, lane_count, 0};
+    unsigned threads = run_workers(lane_worker, &job, worker_count(config, lane_count));
+
+    /* Reconstruction: one shared tree and weights, components in parallel */
+    ProductTree tree;
+    tree_build(&tree, primes, lane_count);
+    uint64_t *weight = checked(malloc(lane_count * sizeof(uint64_t)));
+    tree_weights(&tree, weight);
+
+    mpz_t value[MM_COMPONENTS];
+    for (int c = 0; c < MM_COMPONENTS; ++c) {
+        mpz_init(value[c]);
+    }
+    CrtJob crt = {&tree, primes, weight, residues, value, 0};
+    run_workers(crt_worker, &crt, worker_count(config, MM_COMPONENTS));
+
+    mpz_srcptr modulus = tree_root(&tree);
+    mpz_t half;
+    mpz_init(half);
+    mpz_fdiv_q_2exp(half, modulus, 1);
+
+    /* Fresh 4-slot stack with the oldest entry in slot 0 */
+    state_reset(state, config);
+    Rational *regs[MM_REG_COUNT];
+    state_lane_registers(state, regs);
+    for (int r = 0; r < MM_REG_COUNT; ++r) {
+        for (int k = 0; k < 2; ++k) {
+            mpz_ptr v = value[2 * r + k];
+            if (mpz_cmp(v, half) > 0) {
+                mpz_sub(v, v, modulus);
+            }
+        }
+        rational_set_components(regs[r], value[2 * r], value[2 * r + 1]);
+    }
+    for (int r = 0; r < STATE_GEN_COUNT; ++r) {
+        STATE_TOUCH(state, r);
+    }
+
+    state->koppa_stack_size = bound.stack_size;
+    state->koppa_sample_index = bound.sample_index;
+    state->koppa_sample_held = false;
+    state->rho_pending = bound.rho_pending;
+    state->rho_latched = false;
+    state->psi_recent = bound.psi_recent;
+    state->psi_triple_recent = bound.psi_triple_recent;
+    state->psi_strength_applied = false;
+    state->ratio_triggered_recent = false;
+    state->ratio_threshold_recent = false;
+    state->dual_engine_last_step = bound.dual_engine_last_step;
+    state->sign_flip_polarity = false;
+    state->tick = ticks;
+    state->cycle_period = 0;
+    state->cycle_skipped_ticks = 0;
+
+    if (stats) {
+        stats->primes = lane_count;
+        stats->bound_bits = (size_t)bound_bits;
+        stats->threads = threads;
+    }
+
+    for (int c = 0; c < MM_COMPONENTS; ++c) {
+        mpz_clear(value[c]);
+    }
+    mpz_clear(half);
+    tree_clear(&tree);
+    free(weight);
+    free(primes);
+    free(residues);
+    state_clear(&start);
+    return true;
+}
+
+#else /* !MULTIMOD_AVAILABLE */
+
+bool multimod_admissible(const Config *config) {
+    (void)config;
+    return false;
+}
+
+bool multimod_final(const Config *config, const MultimodProgram *program,
+                    size_t ticks, TRTS_State *state, MultimodStats *stats) {
+    (void)config;
+    (void)program;
+    (void)ticks;
+    (void)state;
+    (void)stats;
+    return false;
+}
+
+#endif /* MULTIMOD_AVAILABLE */
@@ -0,0 +1,92 @@
+/* multimod.h - Multi-Modular (CRT) Final-State Engine
+ *
+ * When no control decision of a run depends on register values, every raw
+ * numerator and denominator is a fixed polynomial in the seed components:
+ * track modes, psi and koppa only add, multiply and swap components, and a
+ * raw division is a cross-multiplication. Such runs are replayed modulo
+ * many 62-bit primes, one independent residue lane per prime spread across
+ * worker threads, and the exact final registers are rebuilt by Chinese
+ * remaindering.
+ *
+ * - A bit-size pass over the same program bounds every component first,
+ *   which fixes the number of primes before any lane starts.
+ * - Admissible runs keep υ, β, κ, ε and everything copied from them
+ *   strictly positive, so no zero test, failed division or 0/0 collapse
+ *   can occur. Deltas may be negative or zero; they are rebuilt in the
+ *   symmetric range and collapse to 0/0 as usual.
+ * - Lanes never touch GMP; only prime generation and the final
+ *   product-tree reconstruction do, on the calling thread.
+ *
+ * Admissible runs: the compiled execution plan (simulate.c) has only ops
+ * the lanes implement, i.e. no pattern checks, ratio triggers or ratio
+ * threshold; and the Config (multimod_admissible) has υ, β, κ seeds with
+ * positive numerator and denominator, no psi strength, conditional triple
+ * psi, koppa gate, β-mod-κ wrap, sign flip, ε-φ swap, delta
+ * cross-propagation, DELTA_ADD or koppa DUMP, and the default koppa stack
+ * depth of 4. Stack-depth modes, all psi modes, triple psi, forced psi at
+ * MT10 and the koppa stack are supported.
+ *
+ * Requires a compiler with 128-bit integers and 64-bit unsigned long;
+ * elsewhere multimod_admissible() is always false.
+ */
+
+#ifndef TRTS_MULTIMOD_H
+#define TRTS_MULTIMOD_H
+
+#include "config.h"
+#include "state.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Statistics for one multi-modular run */
+typedef struct {
+    size_t primes;              /* Residue lanes (62-bit primes) used */
+    size_t bound_bits;          /* Bit bound on the largest final component */
+    unsigned threads;           /* Worker threads used */
+} MultimodStats;
+
+/* Lane counterparts of the execution plan ops that change state */
+typedef enum {
+    MULTIMOD_OP_ENGINE,             /* ε = υ, engine step with the slot's modes */
+    MULTIMOD_OP_FORCED_PSI,         /* MT10_FORCED_PSI: ρ pending */
+    MULTIMOD_OP_REQUEST_PSI,        /* Psi request from stack gate and psi mode */
+    MULTIMOD_OP_REQUEST_PSI_ALWAYS, /* Psi request without stack-depth modes */
+    MULTIMOD_OP_PSI_AND_ACCRUE,     /* Fire psi if requested, accrue κ */
+    MULTIMOD_OP_RESET_ACCRUE        /* Accrue κ without psi */
+} MultimodOp;
+
+#define MULTIMOD_MAX_OPS 8
+
+/* Lane program of one microtick */
+typedef struct {
+    EngineTrackMode ups_mode;       /* Pre-resolved modes (ENGINE op) */
+    EngineTrackMode beta_mode;
+    int op_count;
+    MultimodOp ops[MULTIMOD_MAX_OPS];
+} MultimodSlot;
+
+/* Lane program of a tick, translated from the compiled execution plan by
+ * the simulation; ops that only set event flags are dropped */
+typedef struct {
+    MultimodSlot slot[11];          /* Microticks 1-11 */
+} MultimodProgram;
+
+/* True if config (including its seeds) can run on residue lanes, given a
+ * program for its execution plan. Covers the value-dependent branches
+ * inside the engine, psi and koppa steps, which the plan does not show. */
+bool multimod_admissible(const Config *config);
+
+/* Run ticks ticks of program from the reset state on residue lanes and
+ * rebuild the state after them.
+ *
+ * state must be initialized (state_init). On success it holds exactly the
+ * state stepping would produce (the next_* slots are unspecified) and stats
+ * (may be NULL) is filled in. Uses config->multimodular_threads workers,
+ * or one per online CPU when 0.
+ *
+ * Returns false, leaving state untouched, if the config is not admissible,
+ * the bound exceeds the supported size or memory runs out. */
+bool multimod_final(const Config *config, const MultimodProgram *program,
+                    size_t ticks, TRTS_State *state, MultimodStats *stats);
+
+#endif /* TRTS_MULTIMOD_H */
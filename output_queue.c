@@ -0,0 +1,159 @@
+/* output_queue.c - Background Writer Implementation
+ *
+ * head counts published rows and tail counts written rows; slot i lives
+ * at i % capacity. Only the producer stores head and only the writer
+ * stores tail, so neither needs a lock. Parking uses the Dekker pattern:
+ * a side announces itself in producer_parked/writer_parked and rechecks
+ * the ring before waiting, the other side publishes its index and then
+ * checks the flag, both sequentially consistent, so a wakeup is never
+ * lost.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "output_queue.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/* Ring checks before a side parks */
+#define OUTPUT_QUEUE_SPINS 256
+
+struct OutputQueue {
+    OutputRow *slot;
+    size_t capacity;
+    size_t head;                        /* Rows published (atomic) */
+    size_t tail;                        /* Rows written (atomic) */
+    bool closed;                        /* No more rows (atomic) */
+    bool producer_parked;               /* Waiting for room (atomic) */
+    bool writer_parked;                 /* Waiting for rows (atomic) */
+    pthread_mutex_t lock;
+    pthread_cond_t room;
+    pthread_cond_t rows;
+    pthread_t thread;
+    OutputQueueWriter writer;
+    void *user_data;
+};
+
+/* Helper: wake the other side if it parked on cond */
+static void wake(OutputQueue *queue, bool *parked, pthread_cond_t *cond) {
+    if (__atomic_load_n(parked, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&queue->lock);
+        pthread_cond_signal(cond);
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+/* Helper: true once the writer may read slot tail or must stop */
+static bool writer_ready(OutputQueue *queue, size_t tail) {
+    return __atomic_load_n(&queue->head, __ATOMIC_SEQ_CST) != tail ||
+           __atomic_load_n(&queue->closed, __ATOMIC_SEQ_CST);
+}
+
+static void *writer_main(void *arg) {
+    OutputQueue *queue = arg;
+    size_t tail = queue->tail;
+
+    for (;;) {
+        int spins = 0;
+        while (!writer_ready(queue, tail) && ++spins < OUTPUT_QUEUE_SPINS) {
+        }
+        if (!writer_ready(queue, tail)) {
+            pthread_mutex_lock(&queue->lock);
+            __atomic_store_n(&queue->writer_parked, true, __ATOMIC_SEQ_CST);
+            while (!writer_ready(queue, tail)) {
+                pthread_cond_wait(&queue->rows, &queue->lock);
+            }
+            __atomic_store_n(&queue->writer_parked, false, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&queue->lock);
+        }
+
+        /* Drain everything published before honouring close */
+        size_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            break;
+        }
+        while (tail != head) {
+            queue->writer(queue->user_data, &queue->slot[tail % queue->capacity]);
+            ++tail;
+            __atomic_store_n(&queue->tail, tail, __ATOMIC_SEQ_CST);
+            wake(queue, &queue->producer_parked, &queue->room);
+        }
+    }
+    return NULL;
+}
+
+OutputQueue *output_queue_start(size_t rows, OutputQueueWriter writer, void *user_data) {
+    OutputQueue *queue = calloc(1, sizeof(OutputQueue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->capacity = rows > 0 ? rows : 1;
+    queue->slot = calloc(queue->capacity, sizeof(OutputRow));
+    if (!queue->slot) {
+        free(queue);
+        return NULL;
+    }
+    for (size_t i = 0; i < queue->capacity; ++i) {
+        state_init(&queue->slot[i].state);
+    }
+    queue->writer = writer;
+    queue->user_data = user_data;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->room, NULL);
+    pthread_cond_init(&queue->rows, NULL);
+
+    if (pthread_create(&queue->thread, NULL, writer_main, queue) != 0) {
+        queue->closed = true;
+        queue->writer = NULL;
+        output_queue_finish(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+/* Helper: true once the producer may fill slot head */
+static bool producer_ready(OutputQueue *queue, size_t head) {
+    return head - __atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST) < queue->capacity;
+}
+
+OutputRow *output_queue_acquire(OutputQueue *queue) {
+    size_t head = queue->head;
+    int spins = 0;
+    while (!producer_ready(queue, head) && ++spins < OUTPUT_QUEUE_SPINS) {
+    }
+    if (!producer_ready(queue, head)) {
+        pthread_mutex_lock(&queue->lock);
+        __atomic_store_n(&queue->producer_parked, true, __ATOMIC_SEQ_CST);
+        while (!producer_ready(queue, head)) {
+            pthread_cond_wait(&queue->room, &queue->lock);
+        }
+        __atomic_store_n(&queue->producer_parked, false, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&queue->lock);
+    }
+    return &queue->slot[head % queue->capacity];
+}
+
+void output_queue_publish(OutputQueue *queue) {
+    __atomic_store_n(&queue->head, queue->head + 1, __ATOMIC_SEQ_CST);
+    wake(queue, &queue->writer_parked, &queue->rows);
+}
+
+void output_queue_finish(OutputQueue *queue) {
+    if (!queue) {
+        return;
+    }
+    if (queue->writer) {
+        __atomic_store_n(&queue->closed, true, __ATOMIC_SEQ_CST);
+        wake(queue, &queue->writer_parked, &queue->rows);
+        pthread_join(queue->thread, NULL);
+    }
+
+    for (size_t i = 0; i < queue->capacity; ++i) {
+        state_clear(&queue->slot[i].state);
+    }
+    pthread_cond_destroy(&queue->rows);
+    pthread_cond_destroy(&queue->room);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->slot);
+    free(queue);
+}
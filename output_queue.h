@@ -0,0 +1,59 @@
+/* output_queue.h - Background Writer for Simulation Output
+ *
+ * Moves row formatting and file writes off the simulation thread. The
+ * simulation copies each written microtick into a slot of a bounded
+ * single-producer/single-consumer ring (state_copy into preallocated
+ * states, so steady-state copies reuse their limbs) and a writer thread
+ * formats the slots in order.
+ *
+ * - Slot hand-off is lock-free: head and tail are advanced with atomic
+ *   release/acquire stores.
+ * - A full ring blocks the producer (back-pressure) and an empty ring
+ *   blocks the writer; either side parks on a condition variable only
+ *   after a short spin, and is woken only if it actually parked.
+ * - Rows reach the writer callback in the order they were published.
+ *
+ * With the limb arena enabled, slot limbs are drawn from the simulation
+ * thread's arena. Start and finish the queue inside the arena run: slots
+ * still live at arena_run_end would make the arena retire rather than
+ * release in bulk (see arena.h).
+ */
+
+#ifndef TRTS_OUTPUT_QUEUE_H
+#define TRTS_OUTPUT_QUEUE_H
+
+#include "state.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* One output row: the arguments of a file write and a state copy */
+typedef struct {
+    size_t tick;
+    int microtick;
+    char phase;
+    bool rho_event;
+    bool psi_fired;
+    bool mu_zero;
+    bool forced_emission;
+    TRTS_State state;
+} OutputRow;
+
+/* Called on the writer thread for each row */
+typedef void (*OutputQueueWriter)(void *user_data, const OutputRow *row);
+
+typedef struct OutputQueue OutputQueue;
+
+/* Start a writer thread with a ring of rows slots (>= 1); NULL if the
+ * thread cannot be created (write synchronously instead) */
+OutputQueue *output_queue_start(size_t rows, OutputQueueWriter writer, void *user_data);
+
+/* Producer side: the next free slot, blocking while the ring is full.
+ * Fill it, then publish it. */
+OutputRow *output_queue_acquire(OutputQueue *queue);
+void output_queue_publish(OutputQueue *queue);
+
+/* Wait until every published row is written, stop the thread and free
+ * the queue */
+void output_queue_finish(OutputQueue *queue);
+
+#endif /* TRTS_OUTPUT_QUEUE_H */
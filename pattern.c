@@ -0,0 +1,881 @@
+/* pattern.c - Pattern Test Implementation
+ *
+ * Numeric tests behind a process-wide value cache, plus the per-register
+ * memo and the parallel evaluator for large operands.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pattern.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* ========================================
+   VALUE CACHE
+   ======================================== */
+
+/* Tests cached per magnitude */
+enum {
+    CACHE_PRIME     = 1u << 0,
+    CACHE_POWER     = 1u << 1
+};
+
+typedef struct {
+    unsigned known;                         /* CACHE_* tests run, 0 = empty */
+    unsigned found;                         /* CACHE_* tests that passed */
+    int prime_reps;                         /* Certainty of the CACHE_PRIME result */
+    size_t size;                            /* Limbs of the magnitude */
+    mp_limb_t limb[PATTERN_CACHE_LIMBS];
+} CacheEntry;
+
+static CacheEntry cache_entry[PATTERN_CACHE_SLOTS];
+static pthread_mutex_t cache_lock[PATTERN_CACHE_STRIPES];
+static pthread_once_t cache_once = PTHREAD_ONCE_INIT;
+static PatternCacheStats cache_stats;
+
+static void cache_init_locks(void) {
+    for (int i = 0; i < PATTERN_CACHE_STRIPES; ++i) {
+        pthread_mutex_init(&cache_lock[i], NULL);
+    }
+}
+
+static void cache_count(size_t *counter) {
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+/* Helper: slot of a magnitude (hash of its limbs) */
+static size_t cache_slot(mpz_srcptr value, size_t size) {
+    uint64_t h = (uint64_t)size;
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ (uint64_t)mpz_getlimbn(value, (mp_size_t)i)) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 29;
+    }
+    return (size_t)(h & (PATTERN_CACHE_SLOTS - 1));
+}
+
+/* Helper: does entry e hold |value|? */
+static bool cache_matches(const CacheEntry *e, mpz_srcptr value, size_t size) {
+    if (e->known == 0 || e->size != size) {
+        return false;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        if (e->limb[i] != mpz_getlimbn(value, (mp_size_t)i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Test on a magnitude; reps is the prime test's certainty (ignored by the
+ * others) */
+typedef bool (*MagnitudeTest)(mpz_srcptr magnitude, int reps);
+
+/* Helper: evaluate() on |value| (copies only negative values) */
+static bool evaluate_magnitude(mpz_srcptr value, int reps, MagnitudeTest evaluate) {
+    if (mpz_sgn(value) >= 0) {
+        return evaluate(value, reps);
+    }
+    mpz_t magnitude;
+    mpz_init(magnitude);
+    mpz_abs(magnitude, value);
+    bool result = evaluate(magnitude, reps);
+    mpz_clear(magnitude);
+    return result;
+}
+
+/* Helper: does entry e hold a result of test at this certainty? */
+static bool cache_known(const CacheEntry *e, unsigned test, int reps) {
+    return (e->known & test) && (test != CACHE_PRIME || e->prime_reps == reps);
+}
+
+/* Run test (a CACHE_* bit) on |value| through the cache; evaluate() is
+ * called on |value| on a miss, outside the lock. A prime result only
+ * answers lookups at the reps it was computed with. */
+static bool cache_test(mpz_srcptr value, unsigned test, int reps, MagnitudeTest evaluate) {
+    size_t size = mpz_size(value);
+    if (size > PATTERN_CACHE_LIMBS) {
+        cache_count(&cache_stats.uncached);
+        return evaluate_magnitude(value, reps, evaluate);
+    }
+
+    pthread_once(&cache_once, cache_init_locks);
+    size_t slot = cache_slot(value, size);
+    CacheEntry *e = &cache_entry[slot];
+    pthread_mutex_t *lock = &cache_lock[slot % PATTERN_CACHE_STRIPES];
+    cache_count(&cache_stats.lookups);
+
+    pthread_mutex_lock(lock);
+    if (cache_matches(e, value, size) && cache_known(e, test, reps)) {
+        bool result = (e->found & test) != 0;
+        pthread_mutex_unlock(lock);
+        cache_count(&cache_stats.hits);
+        return result;
+    }
+    pthread_mutex_unlock(lock);
+
+    bool result = evaluate_magnitude(value, reps, evaluate);
+
+    pthread_mutex_lock(lock);
+    if (!cache_matches(e, value, size)) {
+        if (e->known != 0) {
+            cache_count(&cache_stats.evictions);
+        }
+        e->known = 0;
+        e->found = 0;
+        e->size = size;
+        for (size_t i = 0; i < size; ++i) {
+            e->limb[i] = mpz_getlimbn(value, (mp_size_t)i);
+        }
+    }
+    e->known |= test;
+    if (result) {
+        e->found |= test;
+    } else {
+        e->found &= ~test;
+    }
+    if (test == CACHE_PRIME) {
+        e->prime_reps = reps;
+    }
+    pthread_mutex_unlock(lock);
+    return result;
+}
+
+PatternCacheStats pattern_cache_stats(void) {
+    PatternCacheStats stats;
+    stats.lookups = __atomic_load_n(&cache_stats.lookups, __ATOMIC_RELAXED);
+    stats.hits = __atomic_load_n(&cache_stats.hits, __ATOMIC_RELAXED);
+    stats.evictions = __atomic_load_n(&cache_stats.evictions, __ATOMIC_RELAXED);
+    stats.uncached = __atomic_load_n(&cache_stats.uncached, __ATOMIC_RELAXED);
+    stats.too_large = __atomic_load_n(&cache_stats.too_large, __ATOMIC_RELAXED);
+    return stats;
+}
+
+void pattern_cache_reset_stats(void) {
+    __atomic_store_n(&cache_stats.lookups, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache_stats.hits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache_stats.evictions, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache_stats.uncached, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&cache_stats.too_large, 0, __ATOMIC_RELAXED);
+}
+
+/* ========================================
+   NUMERIC TESTS
+   ======================================== */
+
+/* Primality runs in tiers, cheapest first; each tier answers exactly
+ * whatever it can decide, so only the last one is probabilistic:
+ * 1. Single-word values: deterministic Miller-Rabin in native arithmetic.
+ * 2. Wider values: GCD against the primorial of the primes below
+ *    PRIME_SIEVE_LIMIT, held as word-sized chunks.
+ * 3. Survivors: mpz_probab_prime_p (BPSW plus reps - 24 extra rounds). */
+
+#define PRIME_SIEVE_LIMIT 1024          /* Sieve primes are below this */
+#define PRIME_SIEVE_CHUNKS 64           /* Room for the primorial's chunks */
+
+static unsigned long sieve_chunk[PRIME_SIEVE_CHUNKS];
+static int sieve_chunks;
+static pthread_once_t sieve_once = PTHREAD_ONCE_INIT;
+
+/* Split the primorial into products that each fit an unsigned long
+ * (static storage: no GMP allocation) */
+static void sieve_init(void) {
+    bool composite[PRIME_SIEVE_LIMIT] = { false };
+    unsigned long chunk = 1UL;
+    for (unsigned long p = 2UL; p < PRIME_SIEVE_LIMIT; ++p) {
+        if (composite[p]) {
+            continue;
+        }
+        for (unsigned long q = p * p; q < PRIME_SIEVE_LIMIT; q += p) {
+            composite[q] = true;
+        }
+        if (chunk > ULONG_MAX / p) {
+            sieve_chunk[sieve_chunks++] = chunk;
+            chunk = 1UL;
+        }
+        chunk *= p;
+    }
+    sieve_chunk[sieve_chunks++] = chunk;
+}
+
+/* Helper: |value| >= PRIME_SIEVE_LIMIT has a prime factor below the limit */
+static bool sieve_divides(mpz_srcptr magnitude) {
+    pthread_once(&sieve_once, sieve_init);
+    for (int i = 0; i < sieve_chunks; ++i) {
+        if (mpz_gcd_ui(NULL, magnitude, sieve_chunk[i]) != 1UL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#if defined(__SIZEOF_INT128__) && ULONG_MAX >= 0xffffffffffffffffUL
+#define PRIME_WORD_TIER 1
+__extension__ typedef unsigned __int128 word_wide;
+
+static uint64_t word_mulmod(uint64_t a, uint64_t b, uint64_t n) {
+    return (uint64_t)(((word_wide)a * b) % n);
+}
+
+static uint64_t word_powmod(uint64_t base, uint64_t exp, uint64_t n) {
+    uint64_t result = 1;
+    base %= n;
+    while (exp != 0) {
+        if (exp & 1) {
+            result = word_mulmod(result, base, n);
+        }
+        base = word_mulmod(base, base, n);
+        exp >>= 1;
+    }
+    return result;
+}
+
+/* Deterministic Miller-Rabin for n >= 2: the first twelve prime bases
+ * have no common strong pseudoprime below 2^64 */
+static bool word_is_prime(uint64_t n) {
+    static const uint64_t base[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+    const int bases = (int)(sizeof(base) / sizeof(base[0]));
+    for (int i = 0; i < bases; ++i) {
+        if (n % base[i] == 0) {
+            return n == base[i];
+        }
+    }
+
+    uint64_t d = n - 1;
+    int s = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        s++;
+    }
+    for (int i = 0; i < bases; ++i) {
+        uint64_t x = word_powmod(base[i], d, n);
+        if (x == 1 || x == n - 1) {
+            continue;
+        }
+        bool witness = true;
+        for (int r = 1; r < s && witness; ++r) {
+            x = word_mulmod(x, x, n);
+            witness = (x != n - 1);
+        }
+        if (witness) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+/* Tiered primality test on a magnitude >= 2 */
+static bool magnitude_is_prime(mpz_srcptr magnitude, int reps) {
+#ifdef PRIME_WORD_TIER
+    if (mpz_fits_ulong_p(magnitude)) {
+        return word_is_prime((uint64_t)mpz_get_ui(magnitude));
+    }
+#endif
+    if (mpz_cmp_ui(magnitude, PRIME_SIEVE_LIMIT) >= 0 && sieve_divides(magnitude)) {
+        return false;
+    }
+    return mpz_probab_prime_p(magnitude, reps) > 0;
+}
+
+bool pattern_is_prime(const Config *config, mpz_srcptr value) {
+    if (mpz_cmpabs_ui(value, 2UL) < 0) {
+        return false;
+    }
+    if (config->prime_test_max_bits != 0 &&
+        mpz_sizeinbase(value, 2) > config->prime_test_max_bits) {
+        /* Too large to test: the configured answer, never cached */
+        cache_count(&cache_stats.too_large);
+        return config->prime_too_large_is_prime;
+    }
+    return cache_test(value, CACHE_PRIME, config->prime_test_reps, magnitude_is_prime);
+}
+
+/* Fibonacci numbers from F(3) = 2 up in shared, append-only storage.
+ * fib_first[b] is the first entry of b or more bits; a bit length holds
+ * at most two entries (F(k+1) < 2 F(k)). Entries of up to fib_covered bits
+ * are complete and immutable, so lookups below it take no lock. Appends
+ * run under fib_lock and publish the entry count with a release store;
+ * lookups scan only up to the count they acquire. Limbs come from malloc,
+ * not GMP, so extending inside an arena run is safe. */
+
+#define FIB_TABLE_ENTRIES (PATTERN_FIB_TABLE_BITS * 3 / 2 + 8)
+
+typedef struct {
+    size_t bits;
+    size_t size;
+    mp_limb_t *limb;
+} FibEntry;
+
+static FibEntry fib_entry[FIB_TABLE_ENTRIES];
+static size_t fib_entries;                 /* Published entries (atomic) */
+static size_t fib_first[PATTERN_FIB_TABLE_BITS + 2];
+static size_t fib_covered;
+static pthread_mutex_t fib_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Helper: append a single-limb entry */
+static bool fib_append_word(mp_limb_t value) {
+    mp_limb_t *limb = malloc(sizeof(mp_limb_t));
+    if (!limb) {
+        return false;
+    }
+    limb[0] = value;
+    fib_entry[fib_entries].size = 1;
+    fib_entry[fib_entries].limb = limb;
+    fib_entry[fib_entries].bits = mpn_sizeinbase(limb, 1, 2);
+    if (fib_entries == 0 || fib_entry[fib_entries].bits > fib_entry[fib_entries - 1].bits) {
+        fib_first[fib_entry[fib_entries].bits] = fib_entries;
+    }
+    __atomic_store_n(&fib_entries, fib_entries + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Helper: append the sum of the last two entries */
+static bool fib_append_next(void) {
+    const FibEntry *small = &fib_entry[fib_entries - 2];
+    const FibEntry *big = &fib_entry[fib_entries - 1];
+    mp_limb_t *limb = malloc((big->size + 1) * sizeof(mp_limb_t));
+    if (!limb) {
+        return false;
+    }
+    limb[big->size] = mpn_add(limb, big->limb, (mp_size_t)big->size,
+                              small->limb, (mp_size_t)small->size);
+    FibEntry *e = &fib_entry[fib_entries];
+    e->size = big->size + (limb[big->size] != 0);
+    e->limb = limb;
+    e->bits = mpn_sizeinbase(limb, (mp_size_t)e->size, 2);
+    if (e->bits > big->bits) {
+        fib_first[e->bits] = fib_entries;
+    }
+    __atomic_store_n(&fib_entries, fib_entries + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Make the table complete up to bits (<= PATTERN_FIB_TABLE_BITS), growing
+ * it geometrically; false if memory ran out first */
+static bool fib_table_cover(size_t bits) {
+    if (bits <= __atomic_load_n(&fib_covered, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+
+    pthread_mutex_lock(&fib_lock);
+    size_t target = 2 * fib_covered;
+    if (target < bits) {
+        target = bits;
+    }
+    if (target > PATTERN_FIB_TABLE_BITS) {
+        target = PATTERN_FIB_TABLE_BITS;
+    }
+
+    bool ok = true;
+    if (fib_entries == 0) {
+        ok = fib_append_word(2) && fib_append_word(3);
+    }
+    /* Bit length b is complete once an entry is longer than b */
+    while (ok && fib_entry[fib_entries - 1].bits <= target) {
+        ok = fib_append_next();
+    }
+    if (fib_entries > 0) {
+        __atomic_store_n(&fib_covered, fib_entry[fib_entries - 1].bits - 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&fib_lock);
+    return bits <= __atomic_load_n(&fib_covered, __ATOMIC_ACQUIRE);
+}
+
+/* Helper: |value| of the given bit length (>= 2, covered) is in the table */
+static bool fib_table_holds(mpz_srcptr value, size_t bits) {
+    size_t size = mpz_size(value);
+    const mp_limb_t *limb = mpz_limbs_read(value);
+    size_t entries = __atomic_load_n(&fib_entries, __ATOMIC_ACQUIRE);
+    for (size_t i = fib_first[bits]; i < entries && fib_entry[i].bits == bits; ++i) {
+        if (fib_entry[i].size == size && mpn_cmp(fib_entry[i].limb, limb, (mp_size_t)size) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Residue filters for squares and perfect powers. n = m^p forces:
+ * - the 2-adic valuation of n to be a multiple of p, and an odd part
+ *   that is 1 mod 8 when p = 2;
+ * - the exact multiplicity of any small prime to be a multiple of p;
+ * - n mod k to be a p-th power residue mod k for every modulus k.
+ * The moduli form two groups of pairwise coprime numbers whose products
+ * fit an unsigned long, so n is reduced by one mpz_fdiv_ui per group and
+ * each check is a bitmask lookup. Only the exponents that survive, and
+ * exponents too large to filter, reach an exact root. */
+
+#if ULONG_MAX >= 0xffffffffffffffffUL
+#define POWER_FILTER 1
+
+#define POWER_MODULI 21
+#define POWER_GROUP1_MODULI 12          /* Moduli reduced from power_group1 */
+#define POWER_PRIME_POWERS 5            /* Leading moduli that are q^j, j > 1 */
+#define POWER_EXPONENTS 11
+#define POWER_RESIDUE_WORDS 5           /* Bitmask words for moduli < 320 */
+
+static const unsigned long power_modulus[POWER_MODULI] = {
+    27, 25, 49, 121, 169, 17, 19, 23, 29, 31, 37, 41,
+    53, 79, 103, 137, 191, 229, 47, 59, 311
+};
+static const unsigned long power_modulus_prime[POWER_PRIME_POWERS] = { 3, 5, 7, 11, 13 };
+static const unsigned long power_group1 = 27UL * 25 * 49 * 121 * 169 * 17 * 19 * 23 * 29 * 31 * 37 * 41;
+static const unsigned long power_group2 = 53UL * 79 * 103 * 137 * 191 * 229 * 47 * 59 * 311;
+
+/* Prime exponents with residue tables; larger ones are only bounded */
+static const unsigned long power_exponent[POWER_EXPONENTS] = {
+    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31
+};
+#define POWER_LARGE_EXPONENT 37         /* Smallest unfiltered prime exponent */
+#define POWER_FILTER_MIN_LIMBS 1        /* Smaller values skip the filter */
+
+static uint64_t power_residue[POWER_EXPONENTS][POWER_MODULI][POWER_RESIDUE_WORDS];
+static unsigned char power_useful[POWER_EXPONENTS][POWER_MODULI];
+static int power_useful_count[POWER_EXPONENTS];
+static pthread_once_t power_once = PTHREAD_ONCE_INIT;
+
+/* Tabulate the p-th power residues of every modulus, keeping only the
+ * moduli where they are not all residues, most selective first */
+static void power_init(void) {
+    for (int e = 0; e < POWER_EXPONENTS; ++e) {
+        double density[POWER_MODULI];
+        for (int j = 0; j < POWER_MODULI; ++j) {
+            unsigned long k = power_modulus[j];
+            unsigned long count = 0;
+            for (unsigned long y = 0; y < k; ++y) {
+                unsigned long x = 1;
+                for (unsigned long i = 0; i < power_exponent[e]; ++i) {
+                    x = (x * y) % k;
+                }
+                uint64_t bit = (uint64_t)1 << (x % 64);
+                if (!(power_residue[e][j][x / 64] & bit)) {
+                    power_residue[e][j][x / 64] |= bit;
+                    count++;
+                }
+            }
+            if (count == k) {
+                continue;
+            }
+            density[j] = (double)count / (double)k;
+            int u = power_useful_count[e]++;
+            while (u > 0 && density[power_useful[e][u - 1]] > density[j]) {
+                power_useful[e][u] = power_useful[e][u - 1];
+                u--;
+            }
+            power_useful[e][u] = (unsigned char)j;
+        }
+    }
+}
+
+typedef struct {
+    unsigned long residue[2];           /* n mod power_group1, power_group2 */
+    unsigned long multiplicity;         /* gcd of exact small-prime multiplicities, 0 = none known */
+} PowerFilter;
+
+static unsigned long gcd_ul(unsigned long a, unsigned long b) {
+    while (b != 0) {
+        unsigned long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Helper: reduce a positive value and collect the multiplicities */
+static void power_filter_init(PowerFilter *f, mpz_srcptr value) {
+    pthread_once(&power_once, power_init);
+    f->residue[0] = mpz_fdiv_ui(value, power_group1);
+    f->residue[1] = mpz_fdiv_ui(value, power_group2);
+    f->multiplicity = (unsigned long)mpz_scan1(value, 0);
+
+    for (int j = 0; j < POWER_PRIME_POWERS; ++j) {
+        unsigned long q = power_modulus_prime[j];
+        unsigned long r = f->residue[0] % power_modulus[j];
+        if (r == 0 || r % q != 0) {
+            continue;                   /* Multiplicity 0 or not exact */
+        }
+        unsigned long k = 0;
+        while (r % q == 0) {
+            r /= q;
+            k++;
+        }
+        f->multiplicity = gcd_ul(f->multiplicity, k);
+    }
+}
+
+/* Helper: can value (filtered into f) be a p-th power, p = power_exponent[e]? */
+static bool power_filter_passes(const PowerFilter *f, mpz_srcptr value, int e) {
+    unsigned long p = power_exponent[e];
+    if (f->multiplicity != 0 && f->multiplicity % p != 0) {
+        return false;
+    }
+    if (p == 2) {
+        /* An odd square is 1 mod 8 */
+        mp_bitcnt_t t = mpz_scan1(value, 0);
+        if (mpz_tstbit(value, t + 1) || mpz_tstbit(value, t + 2)) {
+            return false;
+        }
+    }
+    for (int u = 0; u < power_useful_count[e]; ++u) {
+        int j = power_useful[e][u];
+        unsigned long x = f->residue[j >= POWER_GROUP1_MODULI] % power_modulus[j];
+        if (!(power_residue[e][j][x / 64] & ((uint64_t)1 << (x % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Helper: can a prime exponent >= POWER_LARGE_EXPONENT divide the known
+ * multiplicities? */
+static bool power_large_exponent_possible(const PowerFilter *f) {
+    unsigned long g = f->multiplicity;
+    if (g == 0) {
+        return true;
+    }
+    for (int e = 0; e < POWER_EXPONENTS; ++e) {
+        while (g % power_exponent[e] == 0) {
+            g /= power_exponent[e];
+        }
+    }
+    return g > 1;
+}
+#endif
+
+/* Check if value is perfect square */
+static bool mpz_is_square(mpz_srcptr value) {
+    if (mpz_sgn(value) <= 0) {
+        return mpz_sgn(value) == 0;
+    }
+#ifdef POWER_FILTER
+    PowerFilter filter;
+    power_filter_init(&filter, value);
+    if (!power_filter_passes(&filter, value, 0)) {
+        return false;
+    }
+#endif
+
+    mpz_t root, rem;
+    mpz_init(root);
+    mpz_init(rem);
+    mpz_sqrtrem(root, rem, value);
+    bool result = (mpz_sgn(rem) == 0);
+    mpz_clear(root);
+    mpz_clear(rem);
+    return result;
+}
+
+/* Fibonacci test on a value >= 2 beyond the table */
+static bool magnitude_is_fibonacci(mpz_srcptr value, int reps) {
+    (void)reps;
+    mpz_t test1, test2, temp;
+    mpz_init(test1);
+    mpz_init(test2);
+    mpz_init(temp);
+
+    /* n is Fibonacci iff one of 5n²+4 or 5n²-4 is perfect square */
+    mpz_mul(temp, value, value);
+    mpz_mul_ui(temp, temp, 5UL);
+
+    mpz_add_ui(test1, temp, 4UL);
+    mpz_sub_ui(test2, temp, 4UL);
+
+    bool result = mpz_is_square(test1) || mpz_is_square(test2);
+
+    mpz_clear(test1);
+    mpz_clear(test2);
+    mpz_clear(temp);
+    return result;
+}
+
+/* |value| is a Fibonacci number: a table lookup up to
+ * PATTERN_FIB_TABLE_BITS bits, the square test beyond */
+static bool magnitude_fibonacci(mpz_srcptr value) {
+    if (mpz_cmpabs_ui(value, 1UL) <= 0) {
+        return true;
+    }
+    size_t bits = mpz_sizeinbase(value, 2);
+    if (bits <= PATTERN_FIB_TABLE_BITS && fib_table_cover(bits)) {
+        return fib_table_holds(value, bits);
+    }
+    return evaluate_magnitude(value, 0, magnitude_is_fibonacci);
+}
+
+bool pattern_is_fibonacci(mpz_srcptr value) {
+    return mpz_sgn(value) >= 0 && magnitude_fibonacci(value);
+}
+
+/* Perfect-power test on a value >= 2 */
+static bool magnitude_is_perfect_power(mpz_srcptr value, int reps) {
+    (void)reps;
+#ifdef POWER_FILTER
+    if (mpz_size(value) <= POWER_FILTER_MIN_LIMBS) {
+        /* GMP's own checks are cheaper than the filter on small values */
+        return mpz_perfect_power_p(value) != 0;
+    }
+    PowerFilter filter;
+    power_filter_init(&filter, value);
+    if (filter.multiplicity == 1) {
+        return false;
+    }
+
+    /* m^p >= 2^p, so exponents of bits or more are impossible */
+    size_t bits = mpz_sizeinbase(value, 2);
+    bool result = false;
+    mpz_t root;
+    mpz_init(root);
+    for (int e = 0; e < POWER_EXPONENTS && power_exponent[e] < bits && !result; ++e) {
+        if (power_filter_passes(&filter, value, e)) {
+            result = mpz_root(root, value, power_exponent[e]) != 0;
+        }
+    }
+    mpz_clear(root);
+    if (result || bits <= POWER_LARGE_EXPONENT || !power_large_exponent_possible(&filter)) {
+        return result;
+    }
+#endif
+    return mpz_perfect_power_p(value) != 0;
+}
+
+/* |value| is a perfect power greater than 1 */
+static bool magnitude_perfect_power(mpz_srcptr value) {
+    if (mpz_cmpabs_ui(value, 1UL) <= 0) {
+        return false;
+    }
+    return cache_test(value, CACHE_POWER, 0, magnitude_is_perfect_power);
+}
+
+bool pattern_is_perfect_power(mpz_srcptr value) {
+    return mpz_sgn(value) >= 0 && magnitude_perfect_power(value);
+}
+
+/* ========================================
+   PER-REGISTER MEMO
+   ======================================== */
+
+/* Helper: register behind a generation index */
+static const Rational *pattern_register(const TRTS_State *st, StateGenerationRegister reg) {
+    switch (reg) {
+        case STATE_GEN_UPSILON:
+            return &st->upsilon;
+        case STATE_GEN_BETA:
+            return &st->beta;
+        default:
+            return &st->koppa;
+    }
+}
+
+/* Helper: evaluate one test on a register value */
+static bool pattern_evaluate(const Config *config, const Rational *value, unsigned test) {
+    switch (test) {
+        case PATTERN_NUM_PRIME:
+            return pattern_is_prime(config, value->num);
+        case PATTERN_NUM_FIBONACCI:
+            return magnitude_fibonacci(value->num);
+        case PATTERN_NUM_POWER:
+            return magnitude_perfect_power(value->num);
+        case PATTERN_DEN_PRIME:
+            return pattern_is_prime(config, value->den);
+        case PATTERN_DEN_FIBONACCI:
+            return pattern_is_fibonacci(value->den);
+        default:
+            return pattern_is_perfect_power(value->den);
+    }
+}
+
+/* Helper: the register's memo, cleared if it was written since */
+static PatternMemo *pattern_memo(TRTS_State *st, StateGenerationRegister reg) {
+    PatternMemo *memo = &st->pattern_memo[reg];
+    if (memo->generation != st->generation[reg]) {
+        /* Written since the memo was filled: forget everything */
+        memo->generation = st->generation[reg];
+        memo->known = 0;
+        memo->found = 0;
+    }
+    return memo;
+}
+
+bool pattern_test(const Config *config, TRTS_State *st, StateGenerationRegister reg,
+                  unsigned test) {
+    PatternMemo *memo = pattern_memo(st, reg);
+    if (!(memo->known & test)) {
+        memo->known |= test;
+        if (pattern_evaluate(config, pattern_register(st, reg), test)) {
+            memo->found |= test;
+        }
+    }
+    return (memo->found & test) != 0;
+}
+
+/* ========================================
+   PARALLEL EVALUATION
+   ======================================== */
+
+#define PATTERN_TESTS 6                 /* PATTERN_* bits */
+
+/* Pending tests of one register, claimed by workers through a cursor */
+typedef struct {
+    const Config *config;
+    const Rational *value;
+    unsigned test[PATTERN_TESTS];
+    bool done[PATTERN_TESTS];           /* Evaluated (skipped once found) */
+    bool hit[PATTERN_TESTS];
+    int count;
+    int cursor;                         /* Next unclaimed test (atomic) */
+    bool found;                         /* Some test hit: cancel the rest (atomic) */
+} PatternJob;
+
+static void *pattern_worker(void *arg) {
+    PatternJob *job = arg;
+    while (!__atomic_load_n(&job->found, __ATOMIC_ACQUIRE)) {
+        int i = __atomic_fetch_add(&job->cursor, 1, __ATOMIC_RELAXED);
+        if (i >= job->count) {
+            break;
+        }
+        job->hit[i] = pattern_evaluate(job->config, job->value, job->test[i]);
+        job->done[i] = true;
+        if (job->hit[i]) {
+            __atomic_store_n(&job->found, true, __ATOMIC_RELEASE);
+        }
+    }
+    return NULL;
+}
+
+/* Helper threads persist for the process: started on the first parallel
+ * call, parked on pool_wake between jobs. One job runs at a time
+ * (pool_use); a concurrent caller tests sequentially instead. */
+static pthread_mutex_t pool_use = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_idle = PTHREAD_COND_INITIALIZER;
+static unsigned pool_threads;           /* Helpers started */
+static PatternJob *pool_job;            /* Current job (pool_lock) */
+static unsigned pool_wanted;            /* Helpers still to join the job */
+static unsigned pool_active;            /* Helpers inside the job */
+
+static void *pool_helper(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (pool_wanted == 0) {
+            pthread_cond_wait(&pool_wake, &pool_lock);
+        }
+        pool_wanted--;
+        pool_active++;
+        PatternJob *job = pool_job;
+        pthread_mutex_unlock(&pool_lock);
+
+        pattern_worker(job);
+
+        pthread_mutex_lock(&pool_lock);
+        if (--pool_active == 0) {
+            pthread_cond_signal(&pool_idle);
+        }
+    }
+    return NULL;
+}
+
+/* Run job on the caller plus up to helpers pool threads. Returns once no
+ * helper is inside the job any more. */
+static void pool_run(PatternJob *job, unsigned helpers) {
+    pthread_mutex_lock(&pool_lock);
+    while (pool_threads < helpers) {
+        pthread_t id;
+        if (pthread_create(&id, NULL, pool_helper, NULL) != 0) {
+            break;
+        }
+        pthread_detach(id);
+        pool_threads++;
+    }
+    pool_job = job;
+    pool_wanted = helpers < pool_threads ? helpers : pool_threads;
+    pthread_cond_broadcast(&pool_wake);
+    pthread_mutex_unlock(&pool_lock);
+
+    pattern_worker(job);
+
+    /* Every test is claimed (or cancelled): helpers not yet awake stay
+     * parked, the ones inside the job finish their running test */
+    pthread_mutex_lock(&pool_lock);
+    pool_wanted = 0;
+    while (pool_active > 0) {
+        pthread_cond_wait(&pool_idle, &pool_lock);
+    }
+    pool_job = NULL;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+/* Helper: workers for count pending tests (at least 1) */
+static unsigned pattern_worker_count(const Config *config, int count) {
+    unsigned threads = config->pattern_threads;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (online > 0) ? (unsigned)online : 1U;
+    }
+    if (threads > (unsigned)count) {
+        threads = (unsigned)count;
+    }
+    return threads;
+}
+
+/* Helper: some pending test has an operand of parallel size */
+static bool pattern_large(const Config *config, const Rational *value, unsigned pending) {
+    if (config->pattern_parallel_bits == 0) {
+        return false;
+    }
+    unsigned num_tests = PATTERN_NUM_PRIME | PATTERN_NUM_FIBONACCI | PATTERN_NUM_POWER;
+    return ((pending & num_tests) &&
+            mpz_sizeinbase(value->num, 2) >= config->pattern_parallel_bits) ||
+           ((pending & ~num_tests) &&
+            mpz_sizeinbase(value->den, 2) >= config->pattern_parallel_bits);
+}
+
+bool pattern_test_any(const Config *config, TRTS_State *st, StateGenerationRegister reg,
+                      unsigned tests) {
+    PatternMemo *memo = pattern_memo(st, reg);
+    if (memo->found & tests) {
+        return true;
+    }
+    unsigned pending = tests & ~memo->known;
+    const Rational *value = pattern_register(st, reg);
+
+    PatternJob job = { config, value, { 0 }, { false }, { false }, 0, 0, false };
+    for (unsigned test = 1; test <= pending; test <<= 1) {
+        if (pending & test) {
+            job.test[job.count++] = test;
+        }
+    }
+    unsigned threads = 1;
+    if (job.count > 1 && pattern_large(config, value, pending)) {
+        threads = pattern_worker_count(config, job.count);
+    }
+    if (threads > 1 && pthread_mutex_trylock(&pool_use) != 0) {
+        threads = 1;  /* Another thread's job holds the helpers */
+    }
+    if (threads <= 1) {
+        /* Sequential, in bit order, stopping at the first hit */
+        for (int i = 0; i < job.count; ++i) {
+            if (pattern_test(config, st, reg, job.test[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* The caller is one of the workers; tests not yet claimed when one
+     * hits are skipped, tests already running are waited for */
+    pool_run(&job, threads - 1);
+    pthread_mutex_unlock(&pool_use);
+
+    for (int i = 0; i < job.count; ++i) {
+        if (job.done[i]) {
+            memo->known |= job.test[i];
+            if (job.hit[i]) {
+                memo->found |= job.test[i];
+            }
+        }
+    }
+    return job.found;
+}
@@ -0,0 +1,100 @@
+/* pattern.h - Pattern Tests on Register Components
+ *
+ * Primality, Fibonacci and perfect-power tests behind the simulation's
+ * pattern triggers and the psi strength parameter. All evaluation happens
+ * outside propagation.
+ *
+ * Results for υ, β and κ are memoized per register in TRTS_State and keyed
+ * by the register's write generation (STATE_TOUCH): a register that has not
+ * been written since a test ran is never re-tested. A memo holds one value
+ * per register, so only the most recent generation is remembered.
+ *
+ * Below the memo, pattern_is_prime/_perfect_power consult a process-wide
+ * cache keyed by the magnitude of the tested integer, so values that recur
+ * across runs and threads (the small seeds of a sweep and their first few
+ * ticks) are tested once per process:
+ * - Direct-mapped, PATTERN_CACHE_SLOTS entries; a colliding value evicts.
+ * - Indexed by a hash of the limbs, confirmed by comparing them exactly.
+ * - Only magnitudes of up to PATTERN_CACHE_LIMBS limbs are cached; larger
+ *   values are rare repeats and are tested directly.
+ * - Entries live in static storage (no GMP allocation, so arena runs are
+ *   unaffected) behind striped mutexes; tests run outside the lock.
+ *
+ * Fibonacci membership needs no cache: a bit length holds at most two
+ * Fibonacci numbers, so up to PATTERN_FIB_TABLE_BITS bits it is a lookup
+ * in a shared table indexed by bit length and extended on demand (one
+ * mpz_sizeinbase and at most two limb compares). Larger values fall back
+ * to the 5n^2 +- 4 square test.
+ *
+ * Primality is tiered: a deterministic word-size Miller-Rabin below 2^64,
+ * a small-prime sieve, then mpz_probab_prime_p at Config.prime_test_reps.
+ * Values wider than Config.prime_test_max_bits are not tested at all and
+ * take the Config.prime_too_large_is_prime answer.
+ */
+
+#ifndef TRTS_PATTERN_H
+#define TRTS_PATTERN_H
+
+#include "config.h"
+#include "state.h"
+#include <gmp.h>
+#include <stdbool.h>
+
+/* Memoizable tests (bits of PatternMemo.known / .found) */
+enum {
+    PATTERN_NUM_PRIME     = 1u << 0,    /* |num| is prime */
+    PATTERN_NUM_FIBONACCI = 1u << 1,    /* |num| is a Fibonacci number */
+    PATTERN_NUM_POWER     = 1u << 2,    /* |num| is a perfect power above 1 */
+    PATTERN_DEN_PRIME     = 1u << 3,    /* |den| is prime */
+    PATTERN_DEN_FIBONACCI = 1u << 4,    /* den is a Fibonacci number (den >= 0) */
+    PATTERN_DEN_POWER     = 1u << 5     /* den is a perfect power above 1 */
+};
+
+#define PATTERN_CACHE_SLOTS    4096     /* Cache entries (power of two) */
+#define PATTERN_CACHE_STRIPES  64       /* Mutexes guarding the entries */
+#define PATTERN_CACHE_LIMBS    4        /* Largest cached magnitude in limbs */
+#define PATTERN_FIB_TABLE_BITS 4096     /* Largest Fibonacci table entry in bits */
+
+/* Process-wide cache counters since start (or pattern_cache_reset_stats) */
+typedef struct {
+    size_t lookups;             /* Tests on cacheable values */
+    size_t hits;                /* Lookups answered from the cache */
+    size_t evictions;           /* Entries replaced by another value */
+    size_t uncached;            /* Tests on values too large to cache */
+    size_t too_large;           /* Prime tests skipped by prime_test_max_bits */
+} PatternCacheStats;
+
+/* |value| is prime (exact below 2^64, probabilistic above at
+ * config->prime_test_reps); values above config->prime_test_max_bits bits
+ * are too large to test and answer config->prime_too_large_is_prime */
+bool pattern_is_prime(const Config *config, mpz_srcptr value);
+
+/* value is a non-negative Fibonacci number */
+bool pattern_is_fibonacci(mpz_srcptr value);
+
+/* value is a perfect power greater than 1 */
+bool pattern_is_perfect_power(mpz_srcptr value);
+
+/* Run one PATTERN_* test on register reg of st, or recall its result if
+ * the register has not been written since */
+bool pattern_test(const Config *config, TRTS_State *st, StateGenerationRegister reg,
+                  unsigned test);
+
+/* Any of the PATTERN_* tests in mask tests holds for register reg of st.
+ * Same result as calling pattern_test on each bit in order until one hits.
+ * When an operand of a pending test has config->pattern_parallel_bits bits
+ * or more, the pending tests run on up to config->pattern_threads workers
+ * (the caller included); once one hits, tests not yet started are skipped.
+ * The other workers are persistent helper threads, started on first use
+ * and parked between calls; while another thread's call holds them, the
+ * tests run sequentially. Every completed test is memoized. */
+bool pattern_test_any(const Config *config, TRTS_State *st, StateGenerationRegister reg,
+                      unsigned tests);
+
+/* Snapshot of the cache counters (exact once worker threads are joined) */
+PatternCacheStats pattern_cache_stats(void);
+
+/* Zero the cache counters; cached results are kept */
+void pattern_cache_reset_stats(void);
+
+#endif /* TRTS_PATTERN_H */
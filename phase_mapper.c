@@ -10,6 +10,7 @@
 
 #include "analysis_utils.h"
 #include "config.h"
+#include "pattern.h"
 
 #define MAX_RESULTS 8192
 #define ARRAY_COUNT(arr) (sizeof(arr) / sizeof((arr)[0]))
@@ -435,6 +436,11 @@ phase_done:
         }
     }
 
+    /* Sweeps revisit the same small seeds, so most pattern tests hit */
+    PatternCacheStats cache = pattern_cache_stats();
+    printf("Pattern cache: %zu of %zu lookups hit, %zu evictions, %zu uncached\n",
+           cache.hits, cache.lookups, cache.evictions, cache.uncached);
+
     free(records);
     config_clear(&config);
     return 0;
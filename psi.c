@@ -5,55 +5,50 @@
  */
 
 #include "psi.h"
+#include "pattern.h"
 #include "rational.h"
 #include <stdbool.h>
 
 /* Standard 2-way psi: (υ,β) → (β/υ, υ/β)
- * Returns false if either division would result in zero denominator */
+ * Returns false if either division would result in zero denominator
+ *
+ * The raw form of υ/β is exactly the component swap of β/υ, so only the two
+ * cross products are computed; each lands in one register by swap and in
+ * the other by copy. */
 static bool standard_psi(TRTS_State *st) {
     if (rational_is_zero(&st->upsilon) || rational_is_zero(&st->beta)) {
         return false;
     }
     
-    Rational new_u, new_b;
-    rational_init(&new_u);
-    rational_init(&new_b);
-    
-    /* new_u = β/υ = (β.num * υ.den) / (β.den * υ.num) */
-    mpz_t t1, t2;
-    mpz_init(t1);
-    mpz_init(t2);
-    
-    mpz_mul(t1, st->beta.num, st->upsilon.den);
-    mpz_mul(t2, st->beta.den, st->upsilon.num);
-    rational_set_components(&new_u, t1, t2);
+    RationalScratch *ws = rational_scratch_local();
+    mpz_ptr p = ws->slot[0];
+    mpz_ptr q = ws->slot[1];
     
-    /* new_b = υ/β = (υ.num * β.den) / (υ.den * β.num) */
-    mpz_mul(t1, st->upsilon.num, st->beta.den);
-    mpz_mul(t2, st->upsilon.den, st->beta.num);
-    rational_set_components(&new_b, t1, t2);
-    
-    /* Check for zero denominators */
-    bool ok = true;
-    if (mpz_sgn(new_u.den) == 0 || mpz_sgn(new_b.den) == 0) {
-        ok = false;
-    }
+    /* β/υ = p/q = (β.num * υ.den) / (β.den * υ.num), υ/β = q/p */
+    mpz_mul(p, st->beta.num, st->upsilon.den);
+    mpz_mul(q, st->beta.den, st->upsilon.num);
     
-    if (ok) {
-        rational_set(&st->upsilon, &new_u);
-        rational_set(&st->beta, &new_b);
+    /* A zero product is a zero denominator in one of the results
+     * (p = 0 also collapses β/υ to 0/0) */
+    if (mpz_sgn(p) == 0 || mpz_sgn(q) == 0) {
+        return false;
     }
     
-    rational_clear(&new_u);
-    rational_clear(&new_b);
-    mpz_clear(t1);
-    mpz_clear(t2);
+    mpz_set(st->beta.num, q);
+    mpz_set(st->beta.den, p);
+    mpz_swap(st->upsilon.num, p);
+    mpz_swap(st->upsilon.den, q);
+    STATE_TOUCH(st, STATE_GEN_UPSILON);
+    STATE_TOUCH(st, STATE_GEN_BETA);
     
-    return ok;
+    return true;
 }
 
 /* Triple 3-way psi: (υ,β,κ) → (β/κ, κ/υ, κ/β)
- * Returns false if any division would result in zero denominator */
+ * Returns false if any division would result in zero denominator
+ *
+ * κ/β is the raw reciprocal of β/κ, so four products cover all three
+ * results. */
 static bool triple_psi(TRTS_State *st) {
     if (rational_is_zero(&st->upsilon) || 
         rational_is_zero(&st->beta) || 
@@ -61,78 +56,48 @@ static bool triple_psi(TRTS_State *st) {
         return false;
     }
     
-    Rational new_u, new_b, new_k;
-    rational_init(&new_u);
-    rational_init(&new_b);
-    rational_init(&new_k);
-    
-    mpz_t t1, t2;
-    mpz_init(t1);
-    mpz_init(t2);
-    
-    /* new_u = β/κ */
-    mpz_mul(t1, st->beta.num, st->koppa.den);
-    mpz_mul(t2, st->beta.den, st->koppa.num);
-    rational_set_components(&new_u, t1, t2);
-    
-    /* new_b = κ/υ */
-    mpz_mul(t1, st->koppa.num, st->upsilon.den);
-    mpz_mul(t2, st->koppa.den, st->upsilon.num);
-    rational_set_components(&new_b, t1, t2);
+    RationalScratch *ws = rational_scratch_local();
+    mpz_ptr bk_num = ws->slot[0];
+    mpz_ptr bk_den = ws->slot[1];
+    mpz_ptr ku_num = ws->slot[2];
+    mpz_ptr ku_den = ws->slot[3];
     
-    /* new_k = κ/β */
-    mpz_mul(t1, st->koppa.num, st->beta.den);
-    mpz_mul(t2, st->koppa.den, st->beta.num);
-    rational_set_components(&new_k, t1, t2);
+    /* β/κ = (β.num * κ.den) / (β.den * κ.num), κ/β is its swap */
+    mpz_mul(bk_num, st->beta.num, st->koppa.den);
+    mpz_mul(bk_den, st->beta.den, st->koppa.num);
     
-    /* Check for zero denominators */
-    bool ok = true;
-   if (mpz_sgn(new_u.den) == 0 || 
-       mpz_sgn(new_b.den) == 0 || 
-       mpz_sgn(new_k.den) == 0) {
-        ok = false;
-    }
+    /* κ/υ = (κ.num * υ.den) / (κ.den * υ.num) */
+    mpz_mul(ku_num, st->koppa.num, st->upsilon.den);
+    mpz_mul(ku_den, st->koppa.den, st->upsilon.num);
     
-    if (ok) {
-        rational_set(&st->upsilon, &new_u);
-        rational_set(&st->beta, &new_b);
-        rational_set(&st->koppa, &new_k);
+    /* Check for zero denominators (a zero numerator collapses to 0/0) */
+    if (mpz_sgn(bk_num) == 0 || mpz_sgn(bk_den) == 0 ||
+        mpz_sgn(ku_num) == 0 || mpz_sgn(ku_den) == 0) {
+        return false;
     }
     
-    rational_clear(&new_u);
-    rational_clear(&new_b);
-    rational_clear(&new_k);
-    mpz_clear(t1);
-    mpz_clear(t2);
-    
-    return ok;
+    mpz_set(st->koppa.num, bk_den);
+    mpz_set(st->koppa.den, bk_num);
+    mpz_swap(st->upsilon.num, bk_num);
+    mpz_swap(st->upsilon.den, bk_den);
+    mpz_swap(st->beta.num, ku_num);
+    mpz_swap(st->beta.den, ku_den);
+    STATE_TOUCH(st, STATE_GEN_UPSILON);
+    STATE_TOUCH(st, STATE_GEN_BETA);
+    STATE_TOUCH(st, STATE_GEN_KOPPA);
+    
+    return true;
 }
 
-/* Count how many of υ, β, κ numerators are prime (for strength parameter) */
-static int prime_count(const TRTS_State *st) {
+/* Count how many of υ, β, κ numerators are prime (for strength parameter);
+ * registers untouched since their last test are not re-tested */
+static int prime_count(const Config *cfg, TRTS_State *st) {
     int count = 0;
-    mpz_t m;
-    mpz_init(m);
-    
-    /* Check upsilon numerator */
-    mpz_abs(m, st->upsilon.num);
-    if (mpz_cmp_ui(m, 2UL) >= 0 && mpz_probab_prime_p(m, 25) > 0) {
-        count++;
-    }
-    
-    /* Check beta numerator */
-    mpz_abs(m, st->beta.num);
-    if (mpz_cmp_ui(m, 2UL) >= 0 && mpz_probab_prime_p(m, 25) > 0) {
-        count++;
-    }
-    
-    /* Check koppa numerator */
-    mpz_abs(m, st->koppa.num);
-    if (mpz_cmp_ui(m, 2UL) >= 0 && mpz_probab_prime_p(m, 25) > 0) {
-        count++;
+    for (int r = 0; r < STATE_GEN_COUNT; ++r) {
+        if (pattern_test(cfg, st, (StateGenerationRegister)r, PATTERN_NUM_PRIME)) {
+            count++;
+        }
     }
-    
-    mpz_clear(m);
     return count;
 }
 
@@ -151,7 +116,7 @@ bool psi_transform(const Config *cfg, TRTS_State *st) {
     /* Determine number of fires (strength parameter) */
     int strength = 1;
     if (cfg->enable_psi_strength_parameter && st->rho_pending) {
-        int pc = prime_count(st);
+        int pc = prime_count(cfg, st);
         strength = (pc > 0) ? pc : 1;
         if (strength > 1) {
             st->psi_strength_applied = true;
@@ -166,7 +131,7 @@ bool psi_transform(const Config *cfg, TRTS_State *st) {
         
         /* Conditional triple: force triple if 3+ primes present */
         if (cfg->enable_conditional_triple_psi) {
-            if (prime_count(st) >= 3) {
+            if (prime_count(cfg, st) >= 3) {
                 request_triple = true;
             }
         }
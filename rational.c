@@ -5,6 +5,8 @@
  */
 
 #include "rational.h"
+#include <limits.h>
+#include <math.h>
 #include <stdlib.h>
 
 /* Helper: enforce 0/0 invariant after any operation */
@@ -31,6 +33,11 @@ void rational_set(Rational *q, const Rational *src) {
     mpz_set(q->den, src->den);
 }
 
+void rational_swap(Rational *a, Rational *b) {
+    mpz_swap(a->num, b->num);
+    mpz_swap(a->den, b->den);
+}
+
 void rational_set_si(Rational *q, long n, unsigned long d) {
     mpz_set_si(q->num, n);
     mpz_set_ui(q->den, d);
@@ -45,79 +52,561 @@ void rational_set_components(Rational *q, const mpz_t num, const mpz_t den) {
     normalize_zero(q);
 }
 
-void rational_add(Rational *r, const Rational *a, const Rational *b) {
+/* ========================================
+   SCRATCH WORKSPACE
+   ======================================== */
+
+/* Thread-local storage qualifier (C11 keyword, GNU extension otherwise) */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define TRTS_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define TRTS_THREAD_LOCAL __thread
+#else
+#define TRTS_THREAD_LOCAL
+#endif
+
+static TRTS_THREAD_LOCAL RationalScratch local_scratch;
+static TRTS_THREAD_LOCAL bool local_scratch_ready = false;
+
+void rational_scratch_init(RationalScratch *ws) {
+    for (int i = 0; i < RATIONAL_SCRATCH_SLOTS; ++i) {
+        mpz_init(ws->slot[i]);
+    }
+}
+
+void rational_scratch_clear(RationalScratch *ws) {
+    for (int i = 0; i < RATIONAL_SCRATCH_SLOTS; ++i) {
+        mpz_clear(ws->slot[i]);
+    }
+}
+
+RationalScratch *rational_scratch_local(void) {
+    if (!local_scratch_ready) {
+        rational_scratch_init(&local_scratch);
+        local_scratch_ready = true;
+    }
+    return &local_scratch;
+}
+
+void rational_scratch_release(void) {
+    if (local_scratch_ready) {
+        rational_scratch_clear(&local_scratch);
+        local_scratch_ready = false;
+    }
+}
+
+/* Helper: move scratch results into r (no copy) and enforce 0/0 */
+static void commit_scratch(Rational *r, mpz_t n, mpz_t d) {
+    mpz_swap(r->num, n);
+    mpz_swap(r->den, d);
+    normalize_zero(r);
+}
+
+/* ========================================
+   SMALL-VALUE FAST PATH
+   ======================================== */
+
+/* When every component fits in a signed machine word the kernels compute
+ * with overflow-checked word arithmetic and write the result back with
+ * mpz_set_si. Any overflow falls through to the GMP path, so the mpz
+ * components stay authoritative and results are identical either way.
+ * Define TRTS_NO_SMALL_FASTPATH to force the GMP path. */
+#if !defined(TRTS_NO_SMALL_FASTPATH) && defined(__GNUC__) && \
+    GMP_NAIL_BITS == 0 && GMP_LIMB_BITS == 64 && LONG_MAX == 0x7fffffffffffffffL
+#define RATIONAL_SMALL_FASTPATH 1
+#else
+#define RATIONAL_SMALL_FASTPATH 0
+#endif
+
+#if RATIONAL_SMALL_FASTPATH
+
+/* Helper: read z as a long if it fits in [-LONG_MAX, LONG_MAX] */
+static bool small_get(mpz_srcptr z, long *out) {
+    size_t limbs = mpz_size(z);
+    if (limbs == 0) {
+        *out = 0;
+        return true;
+    }
+    if (limbs > 1) {
+        return false;
+    }
+    mp_limb_t limb = mpz_getlimbn(z, 0);
+    if (limb > (mp_limb_t)LONG_MAX) {
+        return false;
+    }
+    *out = (mpz_sgn(z) < 0) ? -(long)limb : (long)limb;
+    return true;
+}
+
+/* Helper: read all four components of a and b */
+static bool small_get_pair(const Rational *a, const Rational *b,
+                           long *an, long *ad, long *bn, long *bd) {
+    return small_get(a->num, an) && small_get(a->den, ad) &&
+           small_get(b->num, bn) && small_get(b->den, bd);
+}
+
+/* Helper: store a word-sized result and enforce 0/0 */
+static void small_commit(Rational *r, long n, long d) {
+    mpz_set_si(r->num, n);
+    mpz_set_si(r->den, d);
+    normalize_zero(r);
+}
+
+/* r = a ± b in word arithmetic. Returns false on overflow. */
+static bool small_add_sub(Rational *r, const Rational *a, const Rational *b, bool subtract) {
+    long an, ad, bn, bd, lhs, rhs, n, d;
+    if (!small_get_pair(a, b, &an, &ad, &bn, &bd)) {
+        return false;
+    }
+    if (__builtin_mul_overflow(an, bd, &lhs) ||
+        __builtin_mul_overflow(bn, ad, &rhs) ||
+        __builtin_mul_overflow(ad, bd, &d)) {
+        return false;
+    }
+    if (subtract ? __builtin_sub_overflow(lhs, rhs, &n)
+                 : __builtin_add_overflow(lhs, rhs, &n)) {
+        return false;
+    }
+    small_commit(r, n, d);
+    return true;
+}
+
+/* r = a * b in word arithmetic. Returns false on overflow. */
+static bool small_mul(Rational *r, const Rational *a, const Rational *b) {
+    long an, ad, bn, bd, n, d;
+    if (!small_get_pair(a, b, &an, &ad, &bn, &bd)) {
+        return false;
+    }
+    if (__builtin_mul_overflow(an, bn, &n) ||
+        __builtin_mul_overflow(ad, bd, &d)) {
+        return false;
+    }
+    small_commit(r, n, d);
+    return true;
+}
+
+/* r = a / b in word arithmetic (b.num != 0 checked by caller) */
+static bool small_div(Rational *r, const Rational *a, const Rational *b) {
+    long an, ad, bn, bd, n, d;
+    if (!small_get_pair(a, b, &an, &ad, &bn, &bd)) {
+        return false;
+    }
+    if (__builtin_mul_overflow(an, bd, &n) ||
+        __builtin_mul_overflow(ad, bn, &d)) {
+        return false;
+    }
+    small_commit(r, n, d);
+    return true;
+}
+
+/* Compare a.num*b.den with b.num*a.den in word arithmetic */
+static bool small_cmp(const Rational *a, const Rational *b, int *result) {
+    long an, ad, bn, bd, lhs, rhs;
+    if (!small_get_pair(a, b, &an, &ad, &bn, &bd)) {
+        return false;
+    }
+    if (__builtin_mul_overflow(an, bd, &lhs) ||
+        __builtin_mul_overflow(bn, ad, &rhs)) {
+        return false;
+    }
+    *result = (lhs > rhs) - (lhs < rhs);
+    return true;
+}
+
+/* Helper: read all six components of a, b and c */
+static bool small_get_triple(const Rational *a, const Rational *b, const Rational *c,
+                             long *an, long *ad, long *bn, long *bd, long *cn, long *cd) {
+    return small_get_pair(a, b, an, ad, bn, bd) &&
+           small_get(c->num, cn) && small_get(c->den, cd);
+}
+
+/* Helper: word-sized raw sum xn/xd + yn/yd (before 0/0 collapse) */
+static bool small_raw_sum(long xn, long xd, long yn, long yd, long *n, long *d) {
+    long lhs, rhs;
+    return !__builtin_mul_overflow(xn, yd, &lhs) &&
+           !__builtin_mul_overflow(yn, xd, &rhs) &&
+           !__builtin_add_overflow(lhs, rhs, n) &&
+           !__builtin_mul_overflow(xd, yd, d);
+}
+
+/* r = (a + b) + c in word arithmetic. Returns false on overflow. */
+static bool small_add3(Rational *r, const Rational *a, const Rational *b, const Rational *c) {
+    long an, ad, bn, bd, cn, cd, sn, sd, n, d;
+    if (!small_get_triple(a, b, c, &an, &ad, &bn, &bd, &cn, &cd) ||
+        !small_raw_sum(an, ad, bn, bd, &sn, &sd)) {
+        return false;
+    }
+    if (sn == 0) {
+        small_commit(r, 0, 0);  /* Intermediate collapsed to 0/0 */
+        return true;
+    }
+    if (!small_raw_sum(sn, sd, cn, cd, &n, &d)) {
+        return false;
+    }
+    small_commit(r, n, d);
+    return true;
+}
+
+/* r = a * (b + c) in word arithmetic. Returns false on overflow. */
+static bool small_mul_add(Rational *r, const Rational *a, const Rational *b, const Rational *c) {
+    long an, ad, bn, bd, cn, cd, sn, sd, n, d;
+    if (!small_get_triple(a, b, c, &an, &ad, &bn, &bd, &cn, &cd) ||
+        !small_raw_sum(bn, bd, cn, cd, &sn, &sd)) {
+        return false;
+    }
+    if (sn == 0) {
+        small_commit(r, 0, 0);  /* Intermediate collapsed to 0/0 */
+        return true;
+    }
+    if (__builtin_mul_overflow(an, sn, &n) ||
+        __builtin_mul_overflow(ad, sd, &d)) {
+        return false;
+    }
+    small_commit(r, n, d);
+    return true;
+}
+
+/* r = (a + b) / c in word arithmetic. Returns false on overflow; *ok
+ * reports the zero-denominator failure of the intermediate sum. */
+static bool small_add_then_div(Rational *r, const Rational *a, const Rational *b,
+                               const Rational *c, bool *ok) {
+    long an, ad, bn, bd, cn, cd, sn, sd, n, d;
+    if (!small_get_triple(a, b, c, &an, &ad, &bn, &bd, &cn, &cd) ||
+        !small_raw_sum(an, ad, bn, bd, &sn, &sd)) {
+        return false;
+    }
+    if (sn == 0 || sd == 0) {
+        *ok = false;
+        return true;
+    }
+    if (__builtin_mul_overflow(sn, cd, &n) ||
+        __builtin_mul_overflow(sd, cn, &d)) {
+        return false;
+    }
+    small_commit(r, n, d);
+    *ok = true;
+    return true;
+}
+
+#endif /* RATIONAL_SMALL_FASTPATH */
+
+/* ========================================
+   ARITHMETIC KERNELS
+   ======================================== */
+
+void rational_add_ws(RationalScratch *ws, Rational *r, const Rational *a, const Rational *b) {
     /* r = a + b = (a.num * b.den + b.num * a.den) / (a.den * b.den) */
-    mpz_t n, d, tmp;
-    mpz_init(n);
-    mpz_init(d);
-    mpz_init(tmp);
+#if RATIONAL_SMALL_FASTPATH
+    if (small_add_sub(r, a, b, false)) {
+        return;
+    }
+#endif
+    mpz_ptr n = ws->slot[0];
+    mpz_ptr d = ws->slot[1];
+    mpz_ptr tmp = ws->slot[2];
     
     mpz_mul(n, a->num, b->den);       /* a.num * b.den */
     mpz_mul(tmp, b->num, a->den);     /* b.num * a.den */
     mpz_add(n, n, tmp);               /* sum */
     mpz_mul(d, a->den, b->den);       /* product of denominators */
     
-    rational_set_components(r, n, d);
-    
-    mpz_clear(n);
-    mpz_clear(d);
-    mpz_clear(tmp);
+    commit_scratch(r, n, d);
 }
 
-void rational_sub(Rational *r, const Rational *a, const Rational *b) {
+void rational_sub_ws(RationalScratch *ws, Rational *r, const Rational *a, const Rational *b) {
     /* r = a - b = (a.num * b.den - b.num * a.den) / (a.den * b.den) */
-    mpz_t n, d, tmp;
-    mpz_init(n);
-    mpz_init(d);
-    mpz_init(tmp);
+#if RATIONAL_SMALL_FASTPATH
+    if (small_add_sub(r, a, b, true)) {
+        return;
+    }
+#endif
+    mpz_ptr n = ws->slot[0];
+    mpz_ptr d = ws->slot[1];
+    mpz_ptr tmp = ws->slot[2];
     
     mpz_mul(n, a->num, b->den);
     mpz_mul(tmp, b->num, a->den);
     mpz_sub(n, n, tmp);               /* difference */
     mpz_mul(d, a->den, b->den);
     
-    rational_set_components(r, n, d);
-    
-    mpz_clear(n);
-    mpz_clear(d);
-    mpz_clear(tmp);
+    commit_scratch(r, n, d);
 }
 
-void rational_mul(Rational *r, const Rational *a, const Rational *b) {
+void rational_mul_ws(RationalScratch *ws, Rational *r, const Rational *a, const Rational *b) {
     /* r = a * b = (a.num * b.num) / (a.den * b.den) */
-    mpz_t n, d;
-    mpz_init(n);
-    mpz_init(d);
+#if RATIONAL_SMALL_FASTPATH
+    if (small_mul(r, a, b)) {
+        return;
+    }
+#endif
+    mpz_ptr n = ws->slot[0];
+    mpz_ptr d = ws->slot[1];
     
     mpz_mul(n, a->num, b->num);
     mpz_mul(d, a->den, b->den);
     
-    rational_set_components(r, n, d);
-    
-    mpz_clear(n);
-    mpz_clear(d);
+    commit_scratch(r, n, d);
 }
 
-bool rational_div(Rational *r, const Rational *a, const Rational *b) {
+bool rational_div_ws(RationalScratch *ws, Rational *r, const Rational *a, const Rational *b) {
     /* r = a / b = (a.num * b.den) / (a.den * b.num) */
     if (mpz_sgn(b->num) == 0) {
         return false;  /* Division by zero */
     }
     
-    mpz_t n, d;
-    mpz_init(n);
-    mpz_init(d);
+#if RATIONAL_SMALL_FASTPATH
+    if (small_div(r, a, b)) {
+        return true;
+    }
+#endif
+    mpz_ptr n = ws->slot[0];
+    mpz_ptr d = ws->slot[1];
     
     mpz_mul(n, a->num, b->den);
     mpz_mul(d, a->den, b->num);
     
-    rational_set_components(r, n, d);
+    commit_scratch(r, n, d);
+    return true;
+}
+
+/* Helper: estimate cmp(|x1*y1|, |x2*y2|) for nonzero factors without
+ * multiplying. Returns -1/1 when the estimate is conclusive, 0 otherwise. */
+static int cmp_product_magnitude_estimate(mpz_srcptr x1, mpz_srcptr y1,
+                                          mpz_srcptr x2, mpz_srcptr y2) {
+    /* Bit lengths: |x*y| has bits(x)+bits(y)-1 or bits(x)+bits(y) bits */
+    size_t bits_lhs = mpz_sizeinbase(x1, 2) + mpz_sizeinbase(y1, 2);
+    size_t bits_rhs = mpz_sizeinbase(x2, 2) + mpz_sizeinbase(y2, 2);
+    if (bits_lhs + 1 < bits_rhs) {
+        return -1;
+    }
+    if (bits_rhs + 1 < bits_lhs) {
+        return 1;
+    }
+    
+    /* Leading limbs: mpz_get_d_2exp truncates to a mantissa in [0.5, 1), so
+     * each estimate is within a relative 2^-50 of the true product. Anything
+     * closer than the guard band is left to the exact comparison. */
+    const double guard = ldexp(1.0, -40);
+    long ex1, ey1, ex2, ey2;
+    double lhs = fabs(mpz_get_d_2exp(&ex1, x1)) * fabs(mpz_get_d_2exp(&ey1, y1));
+    double rhs = fabs(mpz_get_d_2exp(&ex2, x2)) * fabs(mpz_get_d_2exp(&ey2, y2));
+    long shift = (ex1 + ey1) - (ex2 + ey2);  /* |shift| <= 1 after tier above */
+    lhs = ldexp(lhs, (int)shift);
+    
+    if (lhs > rhs * (1.0 + guard)) {
+        return 1;
+    }
+    if (lhs < rhs * (1.0 - guard)) {
+        return -1;
+    }
+    return 0;
+}
+
+int rational_cmp_ws(RationalScratch *ws, const Rational *a, const Rational *b) {
+    /* Compare a and b: compute a.num*b.den vs b.num*a.den */
+#if RATIONAL_SMALL_FASTPATH
+    int small_result;
+    if (small_cmp(a, b, &small_result)) {
+        return small_result;
+    }
+#endif
+    /* Tier 1: signs of the two cross products */
+    int sign_lhs = mpz_sgn(a->num) * mpz_sgn(b->den);
+    int sign_rhs = mpz_sgn(b->num) * mpz_sgn(a->den);
+    if (sign_lhs != sign_rhs) {
+        return (sign_lhs > sign_rhs) ? 1 : -1;
+    }
+    if (sign_lhs == 0) {
+        return 0;
+    }
+    
+    /* Tiers 2-3: bit-length bounds, then leading-limb estimate */
+    int magnitude = cmp_product_magnitude_estimate(a->num, b->den, b->num, a->den);
+    if (magnitude != 0) {
+        return sign_lhs * magnitude;
+    }
+    
+    /* Tier 4: exact cross-multiplication */
+    mpz_ptr lhs = ws->slot[0];
+    mpz_ptr rhs = ws->slot[1];
+    
+    mpz_mul(lhs, a->num, b->den);
+    mpz_mul(rhs, b->num, a->den);
+    
+    return mpz_cmp(lhs, rhs);
+}
+
+/* Helper: compare sx*|x1*x2*x3| with sy*|y1*y2*y3|, signs in -1..1 (a
+ * nonzero sign implies nonzero factors) */
+static int cmp_signed_triple(RationalScratch *ws,
+                             int sx, mpz_srcptr x1, mpz_srcptr x2, mpz_srcptr x3,
+                             int sy, mpz_srcptr y1, mpz_srcptr y2, mpz_srcptr y3) {
+    if (sx != sy) {
+        return (sx > sy) ? 1 : -1;
+    }
+    if (sx == 0) {
+        return 0;
+    }
+    
+    /* A triple product has between bits-2 and bits bits */
+    size_t bits_lhs = mpz_sizeinbase(x1, 2) + mpz_sizeinbase(x2, 2) + mpz_sizeinbase(x3, 2);
+    size_t bits_rhs = mpz_sizeinbase(y1, 2) + mpz_sizeinbase(y2, 2) + mpz_sizeinbase(y3, 2);
+    if (bits_lhs + 2 < bits_rhs) {
+        return -sx;
+    }
+    if (bits_rhs + 2 < bits_lhs) {
+        return sx;
+    }
+    
+    mpz_ptr lhs = ws->slot[0];
+    mpz_ptr rhs = ws->slot[1];
+    mpz_mul(lhs, x1, x2);
+    mpz_mul(lhs, lhs, x3);
+    mpz_mul(rhs, y1, y2);
+    mpz_mul(rhs, rhs, y3);
+    int magnitude = mpz_cmpabs(lhs, rhs);
+    return sx * ((magnitude > 0) - (magnitude < 0));
+}
+
+int rational_cmp_quotient_ws(RationalScratch *ws, const Rational *a, const Rational *b,
+                             const Rational *c, bool magnitude) {
+    /* a/b = (a.num*b.den)/(a.den*b.num) =: u/v, compared as u*c.den vs
+     * c.num*v; a zero u is the 0/0 quotient */
+    int su = mpz_sgn(a->num) * mpz_sgn(b->den);
+    int sv = mpz_sgn(a->den) * mpz_sgn(b->num);
+    if (su == 0) {
+        return 0;
+    }
+    if (magnitude) {
+        su = 1;
+        sv = (sv != 0);
+    }
+    return cmp_signed_triple(ws, su * mpz_sgn(c->den), a->num, b->den, c->den,
+                             sv * mpz_sgn(c->num), c->num, a->den, b->num);
+}
+
+/* Helper: raw sum of x and y into (n, d) using tmp (before 0/0 collapse) */
+static void raw_sum(mpz_ptr n, mpz_ptr d, mpz_ptr tmp, const Rational *x, const Rational *y) {
+    mpz_mul(n, x->num, y->den);
+    mpz_mul(tmp, y->num, x->den);
+    mpz_add(n, n, tmp);
+    mpz_mul(d, x->den, y->den);
+}
+
+/* Helper: set r to the collapsed 0/0 value */
+static void commit_zero(Rational *r) {
+    mpz_set_ui(r->num, 0UL);
+    mpz_set_ui(r->den, 0UL);
+}
+
+void rational_add3_ws(RationalScratch *ws, Rational *r, const Rational *a,
+                      const Rational *b, const Rational *c) {
+    /* s = a + b;  r = s + c = (s.num * c.den + c.num * s.den) / (s.den * c.den) */
+#if RATIONAL_SMALL_FASTPATH
+    if (small_add3(r, a, b, c)) {
+        return;
+    }
+#endif
+    mpz_ptr n = ws->slot[0];
+    mpz_ptr d = ws->slot[1];
+    mpz_ptr tmp = ws->slot[2];
+    
+    raw_sum(n, d, tmp, a, b);
+    if (mpz_sgn(n) == 0) {
+        /* Chained form collapses s to 0/0, so r = (0*c.den + c.num*0)/0 */
+        commit_zero(r);
+        return;
+    }
+    
+    mpz_mul(tmp, c->num, d);          /* c.num * s.den (shared s.den) */
+    mpz_mul(n, n, c->den);            /* s.num * c.den */
+    mpz_add(n, n, tmp);
+    mpz_mul(d, d, c->den);            /* s.den * c.den */
     
-    mpz_clear(n);
-    mpz_clear(d);
+    commit_scratch(r, n, d);
+}
+
+void rational_mul_add_ws(RationalScratch *ws, Rational *r, const Rational *a,
+                         const Rational *b, const Rational *c) {
+    /* s = b + c;  r = a * s = (a.num * s.num) / (a.den * s.den) */
+#if RATIONAL_SMALL_FASTPATH
+    if (small_mul_add(r, a, b, c)) {
+        return;
+    }
+#endif
+    mpz_ptr n = ws->slot[0];
+    mpz_ptr d = ws->slot[1];
+    mpz_ptr tmp = ws->slot[2];
+    
+    raw_sum(n, d, tmp, b, c);
+    if (mpz_sgn(n) == 0) {
+        commit_zero(r);
+        return;
+    }
+    
+    mpz_mul(n, a->num, n);
+    mpz_mul(d, a->den, d);
+    
+    commit_scratch(r, n, d);
+}
+
+bool rational_add_then_div_ws(RationalScratch *ws, Rational *r, const Rational *a,
+                              const Rational *b, const Rational *c) {
+    /* s = a + b;  r = s / c = (s.num * c.den) / (s.den * c.num) */
+    if (mpz_sgn(c->num) == 0) {
+        return false;  /* Division by zero */
+    }
+    
+#if RATIONAL_SMALL_FASTPATH
+    bool small_ok;
+    if (small_add_then_div(r, a, b, c, &small_ok)) {
+        return small_ok;
+    }
+#endif
+    mpz_ptr n = ws->slot[0];
+    mpz_ptr d = ws->slot[1];
+    mpz_ptr tmp = ws->slot[2];
+    
+    raw_sum(n, d, tmp, a, b);
+    if (mpz_sgn(n) == 0 || mpz_sgn(d) == 0) {
+        return false;  /* s has a zero denominator */
+    }
+    
+    mpz_mul(n, n, c->den);
+    mpz_mul(d, d, c->num);
+    
+    commit_scratch(r, n, d);
     return true;
 }
 
+void rational_add(Rational *r, const Rational *a, const Rational *b) {
+    rational_add_ws(rational_scratch_local(), r, a, b);
+}
+
+void rational_sub(Rational *r, const Rational *a, const Rational *b) {
+    rational_sub_ws(rational_scratch_local(), r, a, b);
+}
+
+void rational_mul(Rational *r, const Rational *a, const Rational *b) {
+    rational_mul_ws(rational_scratch_local(), r, a, b);
+}
+
+bool rational_div(Rational *r, const Rational *a, const Rational *b) {
+    return rational_div_ws(rational_scratch_local(), r, a, b);
+}
+
+void rational_add3(Rational *r, const Rational *a, const Rational *b, const Rational *c) {
+    rational_add3_ws(rational_scratch_local(), r, a, b, c);
+}
+
+void rational_mul_add(Rational *r, const Rational *a, const Rational *b, const Rational *c) {
+    rational_mul_add_ws(rational_scratch_local(), r, a, b, c);
+}
+
+bool rational_add_then_div(Rational *r, const Rational *a, const Rational *b, const Rational *c) {
+    return rational_add_then_div_ws(rational_scratch_local(), r, a, b, c);
+}
+
 void rational_negate(Rational *q) {
     mpz_neg(q->num, q->num);
     normalize_zero(q);
@@ -220,19 +709,12 @@ void rational_abs_num(mpz_t dest, const Rational *q) {
 }
 
 int rational_cmp(const Rational *a, const Rational *b) {
-    /* Compare a and b: compute a.num*b.den vs b.num*a.den */
-    mpz_t lhs, rhs;
-    mpz_init(lhs);
-    mpz_init(rhs);
-    
-    mpz_mul(lhs, a->num, b->den);
-    mpz_mul(rhs, b->num, a->den);
-    
-    int result = mpz_cmp(lhs, rhs);
-    
-    mpz_clear(lhs);
-    mpz_clear(rhs);
-    return result;
+    return rational_cmp_ws(rational_scratch_local(), a, b);
+}
+
+int rational_cmp_quotient(const Rational *a, const Rational *b, const Rational *c,
+                          bool magnitude) {
+    return rational_cmp_quotient_ws(rational_scratch_local(), a, b, c, magnitude);
 }
 
 int rational_sgn(const Rational *q) {
@@ -16,12 +16,45 @@
 /* TRTS Rational number represented as separate numerator and denominator.
  * Zero-based counting: a rational with numerator 0 must have denominator 0.
  * This represents the undefined/counting state (0/0).
+ *
+ * The mpz components are always authoritative. While all four operand
+ * components fit in a signed machine word, the arithmetic kernels take an
+ * overflow-checked word-arithmetic path and only fall back to GMP
+ * multiplication on overflow (build with -DTRTS_NO_SMALL_FASTPATH to
+ * disable). Both paths produce identical raw results.
  */
 typedef struct {
     mpz_t num;  /* numerator */
     mpz_t den;  /* denominator */
 } Rational;
 
+/* Scratch workspace for the arithmetic kernels.
+ *
+ * Holds a small pool of mpz temporaries that are reused across calls, so the
+ * kernels never mpz_init/mpz_clear per operation. Results are built in the
+ * workspace and swapped into the destination with mpz_swap (the destination's
+ * old limbs become the next call's scratch), which makes every kernel safe
+ * when r aliases a or b. Raw numerator/denominator results are identical to
+ * the textbook cross-multiplication formulas.
+ */
+#define RATIONAL_SCRATCH_SLOTS 4
+
+typedef struct {
+    mpz_t slot[RATIONAL_SCRATCH_SLOTS];
+} RationalScratch;
+
+/* Initialize / clear a caller-owned workspace */
+void rational_scratch_init(RationalScratch *ws);
+void rational_scratch_clear(RationalScratch *ws);
+
+/* Per-thread workspace used by the plain rational_* kernels.
+ * Lazily initialized on first use in each thread. */
+RationalScratch *rational_scratch_local(void);
+
+/* Free the calling thread's workspace (optional, e.g. before thread exit).
+ * A later kernel call in the same thread re-creates it. */
+void rational_scratch_release(void);
+
 /* Initialize rational to 0/1 */
 void rational_init(Rational *q);
 
@@ -31,6 +64,9 @@ void rational_clear(Rational *q);
 /* Copy src to q */
 void rational_set(Rational *q, const Rational *src);
 
+/* Exchange a and b in O(1) (components swapped, no copies) */
+void rational_swap(Rational *a, Rational *b);
+
 /* Set q = n/d with signed numerator and unsigned denominator
  * If n == 0, forces denominator to 0 (0/0 invariant) */
 void rational_set_si(Rational *q, long n, unsigned long d);
@@ -47,6 +83,35 @@ void rational_mul(Rational *r, const Rational *a, const Rational *b);
 /* Division: r = a/b. Returns false if b.num == 0 */
 bool rational_div(Rational *r, const Rational *a, const Rational *b);
 
+/* Fused multi-operand kernels for the engine and koppa formulas.
+ * Each produces exactly the raw numerator/denominator of the equivalent
+ * chained calls (including the 0/0 collapse of the intermediate), while
+ * sharing the intermediate denominator product and skipping the
+ * intermediate store.
+ *
+ * rational_add3:          r = (a + b) + c
+ * rational_mul_add:       r = a * (b + c)
+ * rational_add_then_div:  r = (a + b) / c. Returns false, leaving r
+ *                         unchanged, if c.num == 0 or (a + b) has a zero
+ *                         denominator. */
+void rational_add3(Rational *r, const Rational *a, const Rational *b, const Rational *c);
+void rational_mul_add(Rational *r, const Rational *a, const Rational *b, const Rational *c);
+bool rational_add_then_div(Rational *r, const Rational *a, const Rational *b, const Rational *c);
+
+/* Workspace variants of the kernels above. Identical results; the caller
+ * supplies the scratch pool (e.g. one per worker in a parallel sweep). */
+void rational_add_ws(RationalScratch *ws, Rational *r, const Rational *a, const Rational *b);
+void rational_sub_ws(RationalScratch *ws, Rational *r, const Rational *a, const Rational *b);
+void rational_mul_ws(RationalScratch *ws, Rational *r, const Rational *a, const Rational *b);
+bool rational_div_ws(RationalScratch *ws, Rational *r, const Rational *a, const Rational *b);
+int rational_cmp_ws(RationalScratch *ws, const Rational *a, const Rational *b);
+void rational_add3_ws(RationalScratch *ws, Rational *r, const Rational *a,
+                      const Rational *b, const Rational *c);
+void rational_mul_add_ws(RationalScratch *ws, Rational *r, const Rational *a,
+                         const Rational *b, const Rational *c);
+bool rational_add_then_div_ws(RationalScratch *ws, Rational *r, const Rational *a,
+                              const Rational *b, const Rational *c);
+
 /* Negate q (flip sign of numerator) */
 void rational_negate(Rational *q);
 
@@ -64,9 +129,24 @@ void rational_round(Rational *r, const Rational *q);
 void rational_abs_num(mpz_t dest, const Rational *q);
 
 /* Comparison: returns <0 if a<b, 0 if a==b, >0 if a>b
- * Compares using cross-multiplication without reduction */
+ * Compares a.num*b.den against b.num*a.den without reduction. Tiered so
+ * the products are rarely formed: cross-product signs, then bit-length
+ * bounds (mpz_sizeinbase), then a guarded leading-limb estimate
+ * (mpz_get_d_2exp); only undecided cases fall back to exact
+ * cross-multiplication. Always exact. */
 int rational_cmp(const Rational *a, const Rational *b);
 
+/* Compare the quotient a/b with c without dividing: the same result as
+ * rational_div(&q, a, b) then rational_cmp(&q, c), including the 0/0
+ * collapse of a zero quotient (which compares equal to anything). With
+ * magnitude set, |a/b| is compared instead. b.num must be nonzero.
+ * Decided by signs and bit-length bounds where possible; otherwise the
+ * two triple products are formed in scratch. Always exact. */
+int rational_cmp_quotient(const Rational *a, const Rational *b, const Rational *c,
+                          bool magnitude);
+int rational_cmp_quotient_ws(RationalScratch *ws, const Rational *a, const Rational *b,
+                             const Rational *c, bool magnitude);
+
 /* Sign of rational (-1, 0, or 1) */
 int rational_sgn(const Rational *q);
 
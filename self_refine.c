@@ -11,6 +11,7 @@
 #include "simulate.h"
 #include "analysis_utils.h"
 #include "config.h"
+#include "pattern.h"
 #include "rational.h"
 
 #define ARRAY_COUNT(arr) (sizeof(arr) / sizeof((arr)[0]))
@@ -422,6 +423,10 @@ int main(int argc, char **argv) {
         print_candidate_summary(&population[0], options.generations, 0U);
     }
 
+    PatternCacheStats cache = pattern_cache_stats();
+    printf("Pattern cache: %zu of %zu lookups hit, %zu evictions, %zu uncached\n",
+           cache.hits, cache.lookups, cache.evictions, cache.uncached);
+
     for (size_t i = 0; i < options.population; ++i) {
         candidate_clear(&population[i]);
     }
@@ -5,10 +5,16 @@
  */
 
 #include "simulate.h"
+#include "arena.h"
+#include "csv_writer.h"
 #include "engine.h"
 #include "koppa.h"
+#include "multimod.h"
+#include "output_queue.h"
+#include "pattern.h"
 #include "psi.h"
 #include "rational.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <gmp.h>
@@ -17,243 +23,150 @@
    PATTERN DETECTION (EVALUATION ONLY)
    ======================================== */
 
-/* Check if mpz_t is prime (using absolute value) */
-static bool mpz_is_prime_signed(mpz_srcptr value) {
-    mpz_t magnitude;
-    mpz_init(magnitude);
-    mpz_abs(magnitude, value);
-    
-    bool is_prime = false;
-    if (mpz_cmp_ui(magnitude, 2UL) >= 0) {
-        is_prime = mpz_probab_prime_p(magnitude, 25) > 0;
-    }
-    
-    mpz_clear(magnitude);
-    return is_prime;
-}
-
-/* Check if value is perfect square */
-static bool mpz_is_square(mpz_srcptr value) {
-    if (mpz_sgn(value) < 0) {
-        return false;
-    }
-    
-    mpz_t root;
-    mpz_init(root);
-    mpz_sqrt(root, value);
-    mpz_mul(root, root, root);
-    bool result = (mpz_cmp(root, value) == 0);
-    mpz_clear(root);
-    return result;
-}
-
-/* Check if value is Fibonacci number */
-static bool mpz_is_fibonacci(mpz_srcptr value) {
-    if (mpz_cmp_ui(value, 0UL) < 0) {
-        return false;
-    }
-    if (mpz_cmp_ui(value, 1UL) <= 0) {
-        return true;
-    }
-    
-    mpz_t test1, test2, temp;
-    mpz_init(test1);
-    mpz_init(test2);
-    mpz_init(temp);
-    
-    /* n is Fibonacci iff one of 5n²+4 or 5n²-4 is perfect square */
-    mpz_mul(temp, value, value);
-    mpz_mul_ui(temp, temp, 5UL);
-    
-    mpz_add_ui(test1, temp, 4UL);
-    mpz_sub_ui(test2, temp, 4UL);
-    
-    bool result = mpz_is_square(test1) || mpz_is_square(test2);
-    
-    mpz_clear(test1);
-    mpz_clear(test2);
-    mpz_clear(temp);
-    return result;
-}
-
-/* Check if value is perfect power */
-static bool mpz_is_perfect_power(mpz_srcptr value) {
-    if (mpz_cmp_ui(value, 1UL) <= 0) {
-        return false;
-    }
-    return mpz_perfect_power_p(value) != 0;
-}
-
-/* Check if rational has pattern components in numerator and/or denominator */
-static bool mpq_has_pattern_component(const Config *config, const Rational *value,
+/* Check if register reg has pattern components in numerator and/or
+ * denominator. Tests are memoized against the register's generation and
+ * stop at the first hit; large operands are tested in parallel. */
+static bool mpq_has_pattern_component(const Config *config, TRTS_State *state,
+                                       StateGenerationRegister reg,
                                        bool check_num, bool check_den) {
-    bool found = false;
-    
+    /* A twin prime is prime itself, so the twin prime trigger never adds
+     * to the prime check */
+    unsigned tests = 0;
     if (check_num) {
-        mpz_srcptr num = value->num; 
-        
-        /* Prime check */
-        if (mpz_is_prime_signed(num)) {
-            found = true;
-        }
-        
-        /* Twin prime check */
-        if (config->enable_twin_prime_trigger && mpz_is_prime_signed(num)) {
-            mpz_t temp;
-            mpz_init(temp);
-            
-            mpz_add_ui(temp, num, 2UL);
-            if (mpz_is_prime_signed(temp)) {
-                found = true;
-            }
-            
-            mpz_sub_ui(temp, num, 2UL);
-            if (mpz_is_prime_signed(temp)) {
-                found = true;
-            }
-            
-            mpz_clear(temp);
-        }
-        
-        /* Fibonacci check */
+        tests |= PATTERN_NUM_PRIME;
         if (config->enable_fibonacci_trigger) {
-            mpz_t abs_num;
-            mpz_init(abs_num);
-            mpz_abs(abs_num, num);
-            if (mpz_is_fibonacci(abs_num)) {
-                found = true;
-            }
-            mpz_clear(abs_num);
+            tests |= PATTERN_NUM_FIBONACCI;
         }
-        
-        /* Perfect power check */
         if (config->enable_perfect_power_trigger) {
-            mpz_t abs_num;
-            mpz_init(abs_num);
-            mpz_abs(abs_num, num);
-            if (mpz_is_perfect_power(abs_num)) {
-                found = true;
-            }
-            mpz_clear(abs_num);
+            tests |= PATTERN_NUM_POWER;
         }
     }
     
     if (check_den) {
-        mpz_srcptr den = value->den; 
-        
-        if (mpz_is_prime_signed(den)) {
-            found = true;
-        }
-        if (config->enable_fibonacci_trigger && mpz_is_fibonacci(den)) {
-            found = true;
+        tests |= PATTERN_DEN_PRIME;
+        if (config->enable_fibonacci_trigger) {
+            tests |= PATTERN_DEN_FIBONACCI;
         }
-        if (config->enable_perfect_power_trigger && mpz_is_perfect_power(den)) {
-            found = true;
+        if (config->enable_perfect_power_trigger) {
+            tests |= PATTERN_DEN_POWER;
         }
     }
     
-    return found;
+    return pattern_test_any(config, state, reg, tests);
 }
 
 /* ========================================
    RATIO TRIGGERS (EVALUATION ONLY)
    ======================================== */
 
-/* Get ratio bounds for specific trigger modes */
-static void ratio_bounds(RatioTriggerMode mode, Rational *lower, Rational *upper) {
+/* Ratio triggers are compiled once per run (plan_compile) into exclusive
+ * bands on R = υ/β. R is never formed: its raw form is
+ * (υ.num·β.den)/(υ.den·β.num), so R against a bound p/q is the sign of
+ * υ.num·β.den·q − p·υ.den·β.num (rational_cmp_quotient), which is exact at
+ * any size and usually decided by bit lengths alone. */
+typedef struct {
+    Rational lower;
+    Rational upper;
+} RatioBand;
+
+/* Memoized predicates (bits of RatioMemo.known / .found) */
+enum {
+    RATIO_MEMO_RANGE     = 1u << 0,
+    RATIO_MEMO_THRESHOLD = 1u << 1
+};
+
+/* Set the predefined range band of a trigger mode; false if the mode has
+ * none (such a band would never match) */
+static bool ratio_bounds(RatioTriggerMode mode, Rational *lower, Rational *upper) {
     switch (mode) {
-        case RATIO_TRIGGER_GOLDEN:
+        case RATIO_TRIGGER_PHI:
             rational_set_si(lower, 3, 2);    /* ~1.5 */
             rational_set_si(upper, 17, 10);  /* ~1.7 */
-            break;
-        case RATIO_TRIGGER_SQRT2:
+            return true;
+        case RATIO_TRIGGER_SILVER:
             rational_set_si(lower, 13, 10);  /* ~1.3 */
             rational_set_si(upper, 3, 2);    /* ~1.5 */
-            break;
-        case RATIO_TRIGGER_PLASTIC:
+            return true;
+        case RATIO_TRIGGER_RHO:
             rational_set_si(lower, 6, 5);    /* ~1.2 */
             rational_set_si(upper, 7, 5);    /* ~1.4 */
-            break;
+            return true;
         case RATIO_TRIGGER_NONE:
         case RATIO_TRIGGER_CUSTOM:
         default:
-            rational_set_si(lower, 0, 1);
-            rational_set_si(upper, 0, 1);
-            break;
+            return false;
     }
 }
 
-/* Check if υ/β ratio is within trigger range */
-static bool ratio_in_range(const Config *config, const TRTS_State *state) {
-    if (config->ratio_trigger_mode == RATIO_TRIGGER_NONE) {
-        return false;
-    }
-    if (rational_is_zero(&state->beta)) {
-        return false;
-    }
-    
-    Rational ratio;
-    rational_init(&ratio);
-    if (!rational_div(&ratio, &state->upsilon, &state->beta)) {
-        rational_clear(&ratio);
-        return false;
-    }
-    
-    bool in_range = false;
-    
-    if (config->ratio_trigger_mode == RATIO_TRIGGER_CUSTOM && 
-        config->enable_ratio_custom_range) {
-        /* Use custom bounds */
-        if (rational_cmp(&ratio, &config->ratio_custom_lower) > 0 &&
-            rational_cmp(&ratio, &config->ratio_custom_upper) < 0) {
-            in_range = true;
+/* Compile the range band; false if the range trigger can never fire */
+static bool ratio_range_compile(const Config *config, RatioBand *band) {
+    if (config->ratio_trigger_mode == RATIO_TRIGGER_CUSTOM) {
+        if (!config->enable_ratio_custom_range) {
+            return false;
         }
-    } else {
-        /* Use predefined bounds */
-        Rational lower, upper;
-        rational_init(&lower);
-        rational_init(&upper);
-        ratio_bounds(config->ratio_trigger_mode, &lower, &upper);
-        
-        if (rational_cmp(&ratio, &lower) > 0 &&
-            rational_cmp(&ratio, &upper) < 0) {
-            in_range = true;
-        }
-        
-        rational_clear(&lower);
-        rational_clear(&upper);
+        rational_set(&band->lower, &config->ratio_custom_lower);
+        rational_set(&band->upper, &config->ratio_custom_upper);
+        return true;
     }
-    
-    rational_clear(&ratio);
-    return in_range;
+    return ratio_bounds(config->ratio_trigger_mode, &band->lower, &band->upper);
 }
 
-/* Check if υ/β ratio is outside threshold (extreme values) */
-static bool ratio_threshold_outside(const Config *config, const TRTS_State *state) {
-    if (!config->enable_ratio_threshold_psi) {
-        return false;
+/* Helper: the (υ, β) ratio memo, cleared if either was written since */
+static RatioMemo *ratio_memo(TRTS_State *state) {
+    RatioMemo *memo = &state->ratio_memo;
+    if (memo->upsilon_generation != state->generation[STATE_GEN_UPSILON] ||
+        memo->beta_generation != state->generation[STATE_GEN_BETA]) {
+        memo->upsilon_generation = state->generation[STATE_GEN_UPSILON];
+        memo->beta_generation = state->generation[STATE_GEN_BETA];
+        memo->known = 0;
+        memo->found = 0;
     }
-    if (rational_is_zero(&state->beta)) {
-        return false;
+    return memo;
+}
+
+/* Helper: record and return a memoized predicate result */
+static bool ratio_memo_store(RatioMemo *memo, unsigned predicate, bool result) {
+    memo->known |= predicate;
+    if (result) {
+        memo->found |= predicate;
     }
-    
-    Rational ratio;
-    rational_init(&ratio);
-    if (!rational_div(&ratio, &state->upsilon, &state->beta)) {
-        rational_clear(&ratio);
-        return false;
+    return result;
+}
+
+/* Check if υ/β ratio is strictly inside the range band */
+static bool ratio_in_range(const RatioBand *band, TRTS_State *state) {
+    RatioMemo *memo = ratio_memo(state);
+    if (memo->known & RATIO_MEMO_RANGE) {
+        return (memo->found & RATIO_MEMO_RANGE) != 0;
     }
     
-    /* Manual conversion from Rational struct to double */
-    double ratio_snapshot = 0.0;
-    if (mpz_sgn(ratio.den) != 0) {
-        ratio_snapshot = mpz_get_d(ratio.num) / mpz_get_d(ratio.den);
+    /* Division by zero: no ratio */
+    bool in_range = !rational_is_zero(&state->beta) &&
+        rational_cmp_quotient(&state->upsilon, &state->beta, &band->lower, false) > 0 &&
+        rational_cmp_quotient(&state->upsilon, &state->beta, &band->upper, false) < 0;
+    return ratio_memo_store(memo, RATIO_MEMO_RANGE, in_range);
+}
+
+/* Check if |υ/β| is outside the threshold band (extreme values) */
+static bool ratio_threshold_outside(const RatioBand *band, TRTS_State *state) {
+    RatioMemo *memo = ratio_memo(state);
+    if (memo->known & RATIO_MEMO_THRESHOLD) {
+        return (memo->found & RATIO_MEMO_THRESHOLD) != 0;
     }
     
-    rational_clear(&ratio);
-    
-    double magnitude = (ratio_snapshot >= 0.0) ? ratio_snapshot : -ratio_snapshot;
-    return (magnitude < 0.5 || magnitude > 2.0);
+    bool outside;
+    if (rational_is_zero(&state->beta)) {
+        outside = false;
+    } else if (mpz_sgn(state->upsilon.num) == 0 || mpz_sgn(state->beta.den) == 0 ||
+               mpz_sgn(state->upsilon.den) == 0) {
+        /* A zero numerator or denominator in the raw ratio reads as 0 */
+        outside = true;
+    } else {
+        outside =
+            rational_cmp_quotient(&state->upsilon, &state->beta, &band->lower, true) < 0 ||
+            rational_cmp_quotient(&state->upsilon, &state->beta, &band->upper, true) > 0;
+    }
+    return ratio_memo_store(memo, RATIO_MEMO_THRESHOLD, outside);
 }
 
 /* ========================================
@@ -294,62 +207,184 @@ static bool stack_allows_psi(const Config *config, const TRTS_State *state) {
    OUTPUT HANDLING
    ======================================== */
 
+/* A run of consecutive quiet events.csv rows (no flag set, no koppa
+ * sample) that is written as its first row plus the number of rows it
+ * stands for */
+typedef struct {
+    bool pending;
+    size_t tick;
+    int microtick;
+    char phase;
+    size_t rows;
+    size_t last_tick;                   /* Last microtick in the run */
+    int last_microtick;
+} QuietRun;
+
 typedef struct {
-    FILE *events_file;
-    FILE *values_file;
+    CsvWriter *events;
+    CsvWriter *values;
+    TraceWriter *trace;                 /* Binary trace instead of the CSVs */
+    const Config *config;               /* Row selection (output_*) */
+    QuietRun *quiet;                    /* Collapse quiet events (filtered output) */
+    OutputQueue *queue;                 /* Writer thread, NULL to write inline */
 } SimulationOutputs;
 
-/* Log event flags to CSV */
-static void log_event(FILE *events_file, size_t tick, int microtick, char phase,
-                      bool rho_event, bool psi_fired, bool mu_zero, bool forced_emission,
-                      const TRTS_State *state) {
-    fprintf(events_file,
-            "%zu,%d,%c,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
-            tick, microtick, phase,
-            rho_event ? 1 : 0, psi_fired ? 1 : 0, mu_zero ? 1 : 0,
-            forced_emission ? 1 : 0,
-            state->ratio_triggered_recent ? 1 : 0,
-            state->psi_triple_recent ? 1 : 0,
-            state->dual_engine_last_step ? 1 : 0,
-            state->koppa_sample_index,
-            state->ratio_threshold_recent ? 1 : 0,
-            state->psi_strength_applied ? 1 : 0,
-            state->sign_flip_polarity ? 1 : 0);
-}
-
-/* Log rational values to CSV */
-static void log_values(FILE *values_file, size_t tick, int microtick,
-                       const TRTS_State *state) {
-    
-    /* FIX: Replaced gmp_fprintf with gmp_snprintf followed by fprintf
-     * This avoids the implicit declaration/linking error for gmp_fprintf
-     * and is a highly portable solution. Buffer size is estimated to be large enough. */
-    #define LOG_BUFFER_SIZE 4096 
-    char log_buffer[LOG_BUFFER_SIZE];
+/* True if the row of this microtick is written (Config.output_*). Phase
+ * 'C' rows (cycle skips) are only written as the final state. */
+static bool output_selects(const Config *config, size_t tick, int microtick,
+                           char phase, bool rho_event, bool psi_fired,
+                           bool mu_zero, const TRTS_State *state) {
+    if (config->output_final_only) {
+        return tick == config->ticks && (microtick == 11 || phase == 'C');
+    }
+    if (phase == 'C' || tick < config->output_tick_from ||
+        (config->output_tick_to > 0 && tick > config->output_tick_to)) {
+        return false;
+    }
+    if (config->output_every == 0 && config->output_events == 0) {
+        return true;
+    }
+    if (config->output_every > 0 && tick % config->output_every == 0) {
+        return true;
+    }
+    unsigned events =
+        (psi_fired ? OUTPUT_EVENT_PSI : 0) |
+        (rho_event ? OUTPUT_EVENT_RHO : 0) |
+        (mu_zero ? OUTPUT_EVENT_MU_ZERO : 0) |
+        (state->ratio_triggered_recent || state->ratio_threshold_recent
+             ? OUTPUT_EVENT_RATIO : 0);
+    return (events & config->output_events) != 0;
+}
+
+/* Write the pending quiet run, if any */
+static void quiet_flush(const SimulationOutputs *outputs) {
+    QuietRun *run = outputs->quiet;
+    if (!run || !run->pending) {
+        return;
+    }
+    csv_put_size(outputs->events, run->tick);
+    csv_put_int(outputs->events, run->microtick);
+    csv_put_char(outputs->events, run->phase);
+    for (int i = 0; i < 11; ++i) {
+        /* All flags clear; koppa_sample_index (8th) is -1 */
+        csv_put_int(outputs->events, i == 7 ? -1 : 0);
+    }
+    csv_put_size(outputs->events, run->rows);
+    csv_end_row(outputs->events);
+    run->pending = false;
+}
+
+/* True if tick/microtick is the microtick right after the run's last;
+ * decimated output leaves gaps that must not fold into the count */
+static bool quiet_follows(const QuietRun *run, size_t tick, int microtick) {
+    if (microtick == 1) {
+        return run->last_microtick == 11 && tick == run->last_tick + 1;
+    }
+    return tick == run->last_tick && microtick == run->last_microtick + 1;
+}
+
+/* Log event flags to CSV (with a trailing rows count when quiet rows
+ * are collapsed) */
+static void log_event(const SimulationOutputs *outputs, size_t tick, int microtick,
+                      char phase, bool rho_event, bool psi_fired, bool mu_zero,
+                      bool forced_emission, const TRTS_State *state) {
+    CsvWriter *events = outputs->events;
+    QuietRun *run = outputs->quiet;
+    if (run) {
+        bool quiet = !rho_event && !psi_fired && !mu_zero && !forced_emission &&
+                     !state->ratio_triggered_recent && !state->psi_triple_recent &&
+                     !state->dual_engine_last_step && state->koppa_sample_index < 0 &&
+                     !state->ratio_threshold_recent && !state->psi_strength_applied &&
+                     !state->sign_flip_polarity;
+        if (quiet) {
+            if (run->pending && !quiet_follows(run, tick, microtick)) {
+                quiet_flush(outputs);
+            }
+            if (!run->pending) {
+                run->pending = true;
+                run->tick = tick;
+                run->microtick = microtick;
+                run->phase = phase;
+                run->rows = 0;
+            }
+            run->rows++;
+            run->last_tick = tick;
+            run->last_microtick = microtick;
+            return;
+        }
+        quiet_flush(outputs);
+    }
     
-    /* Use gmp_snprintf to format the entire string into the buffer */
-    gmp_snprintf(log_buffer, LOG_BUFFER_SIZE,
-        "%zu,%d,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%zu,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd",
-        tick, microtick,
-        state->upsilon.num, state->upsilon.den,
-        state->beta.num, state->beta.den,
-        state->koppa.num, state->koppa.den,
-        state->koppa_sample.num, state->koppa_sample.den,
-        state->previous_upsilon.num, state->previous_upsilon.den,
-        state->previous_beta.num, state->previous_beta.den,
-        state->koppa_stack[0].num, state->koppa_stack[0].den,
-        state->koppa_stack[1].num, state->koppa_stack[1].den,
-        state->koppa_stack[2].num, state->koppa_stack[2].den,
-        state->koppa_stack[3].num, state->koppa_stack[3].den,
-        state->koppa_stack_size,
-        state->delta_upsilon.num, state->delta_upsilon.den,
-        state->delta_beta.num, state->delta_beta.den,
-        state->triangle_phi_over_epsilon.num, state->triangle_phi_over_epsilon.den,
-        state->triangle_prev_over_phi.num, state->triangle_prev_over_phi.den,
-        state->triangle_epsilon_over_prev.num, state->triangle_epsilon_over_prev.den);
-
-    /* Use standard C fprintf to write the result, adding the newline */
-    fprintf(values_file, "%s\n", log_buffer);
+    csv_put_size(events, tick);
+    csv_put_int(events, microtick);
+    csv_put_char(events, phase);
+    csv_put_int(events, rho_event ? 1 : 0);
+    csv_put_int(events, psi_fired ? 1 : 0);
+    csv_put_int(events, mu_zero ? 1 : 0);
+    csv_put_int(events, forced_emission ? 1 : 0);
+    csv_put_int(events, state->ratio_triggered_recent ? 1 : 0);
+    csv_put_int(events, state->psi_triple_recent ? 1 : 0);
+    csv_put_int(events, state->dual_engine_last_step ? 1 : 0);
+    csv_put_int(events, state->koppa_sample_index);
+    csv_put_int(events, state->ratio_threshold_recent ? 1 : 0);
+    csv_put_int(events, state->psi_strength_applied ? 1 : 0);
+    csv_put_int(events, state->sign_flip_polarity ? 1 : 0);
+    if (run) {
+        csv_put_size(events, 1);
+    }
+    csv_end_row(events);
+}
+
+static void log_rational(CsvWriter *values, const Rational *value) {
+    csv_put_mpz(values, value->num);
+    csv_put_mpz(values, value->den);
+}
+
+/* Log rational values to CSV (one column pair per koppa stack entry,
+ * oldest first) */
+static void log_values(CsvWriter *values, size_t tick, int microtick,
+                       const TRTS_State *state) {
+    csv_put_size(values, tick);
+    csv_put_int(values, microtick);
+    log_rational(values, &state->upsilon);
+    log_rational(values, &state->beta);
+    log_rational(values, &state->koppa);
+    log_rational(values, state_koppa_sample(state));
+    log_rational(values, &state->previous_upsilon);
+    log_rational(values, &state->previous_beta);
+    for (size_t i = 0; i < state->koppa_stack_capacity; ++i) {
+        log_rational(values, KOPPA_STACK_ENTRY(state, i));
+    }
+    csv_put_size(values, state->koppa_stack_size);
+    log_rational(values, &state->delta_upsilon);
+    log_rational(values, &state->delta_beta);
+    log_rational(values, &state->triangle_phi_over_epsilon);
+    log_rational(values, &state->triangle_prev_over_phi);
+    log_rational(values, &state->triangle_epsilon_over_prev);
+    csv_end_row(values);
+}
+
+/* Write one selected row to the files */
+static void write_outputs(const SimulationOutputs *outputs, size_t tick, int microtick,
+                          char phase, bool rho_event, bool psi_fired, bool mu_zero,
+                          bool forced_emission, const TRTS_State *state) {
+    if (outputs->events) {
+        log_event(outputs, tick, microtick, phase,
+                 rho_event, psi_fired, mu_zero, forced_emission, state);
+    }
+    if (outputs->values) {
+        log_values(outputs->values, tick, microtick, state);
+    }
+    if (outputs->trace) {
+        trace_writer_row(outputs->trace, tick, microtick, phase,
+                         rho_event, psi_fired, mu_zero, forced_emission, state);
+    }
+}
+
+/* OutputQueueWriter: user_data is the SimulationOutputs of the files */
+static void write_queued_row(void *user_data, const OutputRow *row) {
+    write_outputs(user_data, row->tick, row->microtick, row->phase, row->rho_event,
+                  row->psi_fired, row->mu_zero, row->forced_emission, &row->state);
 }
 
 /* Emit outputs to files and/or observer */
@@ -357,13 +392,24 @@ static void emit_outputs(const SimulationOutputs *outputs, size_t tick, int micr
                          char phase, bool rho_event, bool psi_fired, bool mu_zero,
                          bool forced_emission, const TRTS_State *state,
                          SimulateObserver observer, void *user_data) {
-    if (outputs) {
-        if (outputs->events_file) {
-            log_event(outputs->events_file, tick, microtick, phase,
-                     rho_event, psi_fired, mu_zero, forced_emission, state);
-        }
-        if (outputs->values_file) {
-            log_values(outputs->values_file, tick, microtick, state);
+    /* Skipped rows are never formatted */
+    if (outputs && output_selects(outputs->config, tick, microtick, phase,
+                                  rho_event, psi_fired, mu_zero, state)) {
+        if (outputs->queue) {
+            /* Hand a copy to the writer thread (blocks while it is behind) */
+            OutputRow *row = output_queue_acquire(outputs->queue);
+            row->tick = tick;
+            row->microtick = microtick;
+            row->phase = phase;
+            row->rho_event = rho_event;
+            row->psi_fired = psi_fired;
+            row->mu_zero = mu_zero;
+            row->forced_emission = forced_emission;
+            state_copy(&row->state, state);
+            output_queue_publish(outputs->queue);
+        } else {
+            write_outputs(outputs, tick, microtick, phase, rho_event, psi_fired,
+                          mu_zero, forced_emission, state);
         }
     }
     
@@ -374,133 +420,715 @@ static void emit_outputs(const SimulationOutputs *outputs, size_t tick, int micr
 }
 
 /* ========================================
-   CORE SIMULATION LOOP
+   EXECUTION PLAN
    ======================================== */
 
-static void run_simulation(const Config *config, const SimulationOutputs *outputs,
-                           SimulateObserver observer, void *user_data) {
-    TRTS_State state;
-    state_init(&state);
-    state_reset(&state, config);
+/* Event flags produced by one microtick */
+typedef struct {
+    bool rho_event;
+    bool psi_fired;
+    bool mu_zero;
+    bool forced_emission;
+    bool allow_stack;           /* Stack-depth gate for psi (M phase) */
+    bool request_psi;           /* Psi requested this microtick (M phase) */
+} MicrotickEvents;
+
+typedef struct PlanSlot PlanSlot;
+
+/* One step of a microtick's compiled program */
+typedef void (*PlanOp)(const Config *config, TRTS_State *state,
+                       const PlanSlot *slot, MicrotickEvents *ev);
+
+#define PLAN_MAX_OPS 8
+
+/* Compiled program for one microtick: phase, pre-resolved engine modes
+ * (E phase only) and the ops that remain after disabled features are
+ * dropped, in the order the original phase switch ran them */
+struct PlanSlot {
+    int microtick;
+    char phase;
+    EngineTrackMode ups_mode;
+    EngineTrackMode beta_mode;
+    const RatioBand *ratio_range;       /* Compiled bands (M phase) */
+    const RatioBand *ratio_threshold;
+    int op_count;
+    PlanOp ops[PLAN_MAX_OPS];
+};
+
+typedef struct {
+    PlanSlot slot[11];
+    RatioBand ratio_range;
+    RatioBand ratio_threshold;
+} ExecutionPlan;
+
+/* E phase: the engine's κ wrap may overwrite κ while the koppa_sample
+ * view still refers to its value from the start of the microtick */
+static void op_hold_koppa_sample(const Config *config, TRTS_State *state,
+                                 const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)config;
+    (void)slot;
+    (void)ev;
+    state_hold_koppa_sample(state);
+}
+
+/* E phase: compute ε and run the engine with hoisted track modes */
+static void op_engine(const Config *config, TRTS_State *state,
+                      const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)ev;
+    rational_set(&state->epsilon, &state->upsilon);
+    (void)engine_step_resolved(config, state, slot->ups_mode, slot->beta_mode);
+}
+
+/* E phase: check for patterns in new upsilon */
+static void op_pattern_new_upsilon(const Config *config, TRTS_State *state,
+                                   const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)slot;
+    if (mpq_has_pattern_component(config, state, STATE_GEN_UPSILON, true, false)) {
+        state->rho_pending = true;
+        ev->rho_event = true;
+    }
+}
+
+/* Microtick 10: forced emission */
+static void op_forced_emission(const Config *config, TRTS_State *state,
+                               const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)config;
+    (void)state;
+    (void)slot;
+    ev->forced_emission = true;
+}
+
+/* Microtick 10: MT10_FORCED_PSI */
+static void op_forced_psi(const Config *config, TRTS_State *state,
+                          const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)config;
+    (void)slot;
+    state->rho_pending = true;
+    ev->rho_event = true;
+}
+
+/* M phase: μ-zero flag */
+static void op_mu_zero(const Config *config, TRTS_State *state,
+                       const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)config;
+    (void)slot;
+    ev->mu_zero = rational_is_zero(&state->beta);
+}
+
+/* M phase: check for patterns in memory (beta) */
+static void op_pattern_memory(const Config *config, TRTS_State *state,
+                              const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)slot;
+    if (mpq_has_pattern_component(config, state, STATE_GEN_BETA, true, true)) {
+        state->rho_pending = true;
+        ev->rho_event = true;
+    }
+}
+
+/* M phase: psi request from stack gate and psi mode */
+static void op_request_psi(const Config *config, TRTS_State *state,
+                           const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)slot;
+    ev->allow_stack = stack_allows_psi(config, state);
+    ev->request_psi = should_fire_psi(config, state, true, ev->allow_stack);
+}
+
+/* M phase: psi request without stack-depth modes (allow_stack stays true) */
+static void op_request_psi_always(const Config *config, TRTS_State *state,
+                                  const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)config;
+    (void)state;
+    (void)slot;
+    ev->request_psi = true;
+}
+
+/* M phase: ratio range trigger */
+static void op_ratio_range(const Config *config, TRTS_State *state,
+                           const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)config;
+    if (ratio_in_range(slot->ratio_range, state)) {
+        ev->request_psi = true;
+        state->ratio_triggered_recent = true;
+    }
+}
+
+/* M phase: ratio threshold trigger */
+static void op_ratio_threshold(const Config *config, TRTS_State *state,
+                               const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)config;
+    if (ratio_threshold_outside(slot->ratio_threshold, state)) {
+        ev->request_psi = true;
+        state->ratio_threshold_recent = true;
+    }
+}
+
+/* M phase: fire psi if conditions met, then accrue koppa */
+static void op_psi_and_accrue(const Config *config, TRTS_State *state,
+                              const PlanSlot *slot, MicrotickEvents *ev) {
+    if (ev->request_psi && ev->allow_stack) {
+        ev->psi_fired = psi_transform(config, state);
+    } else {
+        state->psi_recent = false;
+    }
+    koppa_accrue(config, state, ev->psi_fired, true, slot->microtick);
+    state->rho_latched = false;
+}
+
+/* R phase: accrue koppa without psi */
+static void op_reset_accrue(const Config *config, TRTS_State *state,
+                            const PlanSlot *slot, MicrotickEvents *ev) {
+    (void)ev;
+    koppa_accrue(config, state, false, false, slot->microtick);
+    state->psi_recent = false;
+    state->rho_latched = false;
+}
+
+static void plan_push(PlanSlot *slot, PlanOp op) {
+    slot->ops[slot->op_count++] = op;
+}
+
+/* Compile Config into a per-microtick program and the ratio bands.
+ * Everything decided by Config alone (phase, track modes, enabled checks,
+ * band bounds) is resolved here once; release with plan_clear. */
+static void plan_compile(const Config *config, ExecutionPlan *plan) {
+    rational_init(&plan->ratio_range.lower);
+    rational_init(&plan->ratio_range.upper);
+    rational_init(&plan->ratio_threshold.lower);
+    rational_init(&plan->ratio_threshold.upper);
+    bool ratio_range = ratio_range_compile(config, &plan->ratio_range);
+    rational_set_si(&plan->ratio_threshold.lower, 1, 2);
+    rational_set_si(&plan->ratio_threshold.upper, 2, 1);
     
-    /* Run for configured number of ticks */
-    for (size_t tick = 1; tick <= config->ticks; ++tick) {
-        state.tick = tick;
+    for (int microtick = 1; microtick <= 11; ++microtick) {
+        PlanSlot *slot = &plan->slot[microtick - 1];
+        slot->microtick = microtick;
+        slot->op_count = 0;
+        slot->ups_mode = ENGINE_TRACK_ADD;
+        slot->beta_mode = ENGINE_TRACK_ADD;
+        slot->ratio_range = &plan->ratio_range;
+        slot->ratio_threshold = &plan->ratio_threshold;
         
-        /* 11 microticks per tick */
-        for (int microtick = 1; microtick <= 11; ++microtick) {
-            /* Determine phase */
-            char phase;
-            switch (microtick) {
-                case 1: case 4: case 7: case 10:
-                    phase = 'E';  /* Epsilon phase */
-                    break;
-                case 2: case 5: case 8: case 11:
-                    phase = 'M';  /* Memory phase */
-                    break;
-                default:
-                    phase = 'R';  /* Reset phase */
-                    break;
-            }
-            
-            /* Initialize event flags */
-            bool rho_event = false;
-            bool psi_fired = false;
-            bool mu_zero = false;
-            bool forced_emission = false;
-            
-            /* Clear per-microtick flags */
-            state.ratio_triggered_recent = false;
-            state.psi_triple_recent = false;
-            state.dual_engine_last_step = false;
-            state.koppa_sample_index = -1;
-            rational_set(&state.koppa_sample, &state.koppa);
-            state.ratio_threshold_recent = false;
-            state.psi_strength_applied = false;
-            
-            /* Execute phase logic */
-            switch (phase) {
-                case 'E': {
-                    /* Epsilon phase: compute ε and run engine */
-                    rational_set(&state.epsilon, &state.upsilon);
-                    (void)engine_step(config, &state, microtick);
-                    
-                    /* Check for patterns in new upsilon */
-                    if (config->prime_target == PRIME_ON_NEW_UPSILON) {
-                        if (mpq_has_pattern_component(config, &state.upsilon, true, false)) {
-                            state.rho_pending = true;
-                            rho_event = true;
-                        }
-                    }
-                    
-                    /* Microtick 10 special behavior */
-                    forced_emission = (microtick == 10);
-                    if (microtick == 10 && config->mt10_behavior == MT10_FORCED_PSI) {
-                        state.rho_pending = true;
-                        rho_event = true;
-                    }
-                    break;
+        switch (microtick) {
+            case 1: case 4: case 7: case 10:
+                slot->phase = 'E';  /* Epsilon phase */
+                engine_resolve_modes(config, microtick, &slot->ups_mode, &slot->beta_mode);
+                if (config->enable_beta_mod_koppa_wrap) {
+                    plan_push(slot, op_hold_koppa_sample);
                 }
-                
-                case 'M': {
-                    /* Memory phase: pattern check, psi decision, koppa accrue */
-                    mu_zero = rational_is_zero(&state.beta);
-                    
-                    /* Check for patterns in memory (beta) */
-                    if (config->prime_target == PRIME_ON_MEMORY) {
-                        if (mpq_has_pattern_component(config, &state.beta, true, true)) {
-                            state.rho_pending = true;
-                            rho_event = true;
-                        }
-                    }
-                    
-                    /* Determine if psi should fire */
-                    bool allow_stack = stack_allows_psi(config, &state);
-                    bool request_psi = should_fire_psi(config, &state, true, allow_stack);
-                    
-                    /* Check ratio triggers */
-                    bool ratio_triggered = ratio_in_range(config, &state);
-                    if (ratio_triggered) {
-                        request_psi = true;
-                        state.ratio_triggered_recent = true;
-                    }
-                    
-                    bool ratio_threshold = ratio_threshold_outside(config, &state);
-                    if (ratio_threshold) {
-                        request_psi = true;
-                        state.ratio_threshold_recent = true;
-                    }
-                    
-                    /* Fire psi if conditions met */
-                    if (request_psi && allow_stack) {
-                        psi_fired = psi_transform(config, &state);
-                    } else {
-                        state.psi_recent = false;
+                plan_push(slot, op_engine);
+                if (config->prime_target == PRIME_ON_CURRENT) {
+                    plan_push(slot, op_pattern_new_upsilon);
+                }
+                if (microtick == 10) {
+                    plan_push(slot, op_forced_emission);
+                    if (config->mt10_behavior == MT10_FORCED_PSI) {
+                        plan_push(slot, op_forced_psi);
                     }
-                    
-                    /* Accrue koppa and reset rho latch */
-                    koppa_accrue(config, &state, psi_fired, true, microtick);
-                    state.rho_latched = false;
-                    break;
                 }
-                
-                case 'R': {
-                    /* Reset phase: accrue koppa without psi */
-                    koppa_accrue(config, &state, false, false, microtick);
-                    state.psi_recent = false;
-                    state.rho_latched = false;
-                    break;
+                break;
+            case 2: case 5: case 8: case 11:
+                slot->phase = 'M';  /* Memory phase */
+                plan_push(slot, op_mu_zero);
+                if (config->prime_target == PRIME_ON_MEMORY) {
+                    plan_push(slot, op_pattern_memory);
                 }
+                /* MSTEP and MSTEP_RHO always request when the stack allows */
+                if (!config->enable_stack_depth_modes &&
+                    (config->psi_mode == PSI_MODE_MSTEP ||
+                     config->psi_mode == PSI_MODE_MSTEP_RHO)) {
+                    plan_push(slot, op_request_psi_always);
+                } else {
+                    plan_push(slot, op_request_psi);
+                }
+                if (ratio_range) {
+                    plan_push(slot, op_ratio_range);
+                }
+                if (config->enable_ratio_threshold_psi) {
+                    plan_push(slot, op_ratio_threshold);
+                }
+                plan_push(slot, op_psi_and_accrue);
+                break;
+            default:
+                slot->phase = 'R';  /* Reset phase */
+                plan_push(slot, op_reset_accrue);
+                break;
+        }
+    }
+}
+
+static void plan_clear(ExecutionPlan *plan) {
+    rational_clear(&plan->ratio_range.lower);
+    rational_clear(&plan->ratio_range.upper);
+    rational_clear(&plan->ratio_threshold.lower);
+    rational_clear(&plan->ratio_threshold.upper);
+}
+
+/* ========================================
+   CYCLE DETECTION
+   ======================================== */
+
+/* Brent's algorithm over tick-boundary states. The saved state moves to the
+ * current one whenever the search length reaches a power of two, so the
+ * first exact return yields the minimal period. Hashes screen candidates;
+ * state_equal confirms on raw components. */
+typedef struct {
+    bool enabled;
+    bool searching;
+    TRTS_State saved;
+    uint64_t saved_hash;
+    size_t power;
+    size_t length;
+} CycleDetector;
+
+static void cycle_begin(CycleDetector *cd, const Config *config, const TRTS_State *state) {
+    cd->enabled = config->enable_cycle_detection;
+    cd->searching = cd->enabled;
+    if (!cd->enabled) {
+        return;
+    }
+    state_init(&cd->saved);
+    state_copy(&cd->saved, state);
+    cd->saved_hash = state_hash(state);
+    cd->power = 1;
+    cd->length = 0;
+}
+
+/* Feed the state after a tick. Returns the period once a cycle is
+ * confirmed (searching stops), 0 otherwise. */
+static size_t cycle_observe(CycleDetector *cd, const TRTS_State *state) {
+    if (!cd->searching) {
+        return 0;
+    }
+    uint64_t hash = state_hash(state);
+    cd->length++;
+    if (hash == cd->saved_hash && state_equal(state, &cd->saved)) {
+        cd->searching = false;
+        return cd->length;
+    }
+    if (cd->length == cd->power) {
+        state_copy(&cd->saved, state);
+        cd->saved_hash = hash;
+        cd->power *= 2;
+        cd->length = 0;
+    }
+    return 0;
+}
+
+static void cycle_end(CycleDetector *cd) {
+    if (cd->enabled) {
+        state_clear(&cd->saved);
+    }
+}
+
+/* Record a detected cycle, skip whole periods toward the last tick and
+ * emit a "cycle skipped" event (phase 'C', microtick 0, tick = last
+ * skipped tick) to the observer, and to the files only as a final-state
+ * row. The remaining ticks, fewer than one period, are stepped normally
+ * so the run ends at the right phase of the cycle.
+ * Returns the tick to continue from. */
+static size_t cycle_skip(const Config *config, TRTS_State *state, size_t tick,
+                         size_t period, const SimulationOutputs *outputs,
+                         SimulateObserver observer, void *user_data) {
+    size_t skip = (config->ticks - tick) / period * period;
+    tick += skip;
+    state->tick = tick;
+    state->cycle_period = period;
+    state->cycle_skipped_ticks = skip;
+    emit_outputs(outputs, tick, 0, 'C', false, false, false, false, state,
+                 observer, user_data);
+    return tick;
+}
+
+/* ========================================
+   CORE SIMULATION LOOP
+   ======================================== */
+
+/* Interpret one tick (11 microticks) of the compiled plan */
+static void run_tick(const ExecutionPlan *plan, const Config *config,
+                     TRTS_State *state, size_t tick,
+                     const SimulationOutputs *outputs,
+                     SimulateObserver observer, void *user_data) {
+    state->tick = tick;
+    
+    for (int microtick = 1; microtick <= 11; ++microtick) {
+        const PlanSlot *slot = &plan->slot[microtick - 1];
+        MicrotickEvents ev = {false, false, false, false, true, false};
+        
+        /* Clear per-microtick flags */
+        state->ratio_triggered_recent = false;
+        state->psi_triple_recent = false;
+        state->dual_engine_last_step = false;
+        state->koppa_sample_index = -1;
+        state->koppa_sample_held = false;
+        state->ratio_threshold_recent = false;
+        state->psi_strength_applied = false;
+        
+        for (int i = 0; i < slot->op_count; ++i) {
+            slot->ops[i](config, state, slot, &ev);
+        }
+        
+        /* Emit outputs */
+        emit_outputs(outputs, tick, microtick, slot->phase, ev.rho_event,
+                    ev.psi_fired, ev.mu_zero, ev.forced_emission, state,
+                    observer, user_data);
+    }
+}
+
+/* ========================================
+   LINEAR FAST-FORWARD
+   ======================================== */
+
+/* With ADD track modes, no psi and positive integer registers (den 1),
+ * every raw operation of a tick is an integer linear combination of
+ * (υ, β, κ, ε) numerators and every denominator stays 1. A tick is then a
+ * fixed 4x4 matrix and N ticks are its N-th power. */
+
+enum { LIN_U, LIN_B, LIN_K, LIN_E, LIN_DIM };
+
+typedef struct {
+    mpz_t a[LIN_DIM][LIN_DIM];
+} LinearMap;
+
+static void linear_init_identity(LinearMap *m) {
+    for (int i = 0; i < LIN_DIM; ++i) {
+        for (int j = 0; j < LIN_DIM; ++j) {
+            mpz_init_set_ui(m->a[i][j], i == j ? 1UL : 0UL);
+        }
+    }
+}
+
+static void linear_clear(LinearMap *m) {
+    for (int i = 0; i < LIN_DIM; ++i) {
+        for (int j = 0; j < LIN_DIM; ++j) {
+            mpz_clear(m->a[i][j]);
+        }
+    }
+}
+
+/* r = x * y (r may alias x or y) */
+static void linear_mul(LinearMap *r, const LinearMap *x, const LinearMap *y) {
+    LinearMap t;
+    linear_init_identity(&t);
+    for (int i = 0; i < LIN_DIM; ++i) {
+        for (int j = 0; j < LIN_DIM; ++j) {
+            mpz_set_ui(t.a[i][j], 0UL);
+            for (int k = 0; k < LIN_DIM; ++k) {
+                mpz_addmul(t.a[i][j], x->a[i][k], y->a[k][j]);
+            }
+        }
+    }
+    for (int i = 0; i < LIN_DIM; ++i) {
+        for (int j = 0; j < LIN_DIM; ++j) {
+            mpz_swap(r->a[i][j], t.a[i][j]);
+        }
+    }
+    linear_clear(&t);
+}
+
+/* Compose the assignment row[dst] = sum of rows in src_mask onto m
+ * (m holds the map accumulated so far, so rows combine old values) */
+static void linear_assign(LinearMap *m, int dst, unsigned src_mask) {
+    mpz_t sum[LIN_DIM];
+    for (int j = 0; j < LIN_DIM; ++j) {
+        mpz_init(sum[j]);
+        for (int src = 0; src < LIN_DIM; ++src) {
+            if (src_mask & (1U << src)) {
+                mpz_add(sum[j], sum[j], m->a[src][j]);
             }
-            
-            /* Emit outputs */
-            emit_outputs(outputs, tick, microtick, phase, rho_event,
-                        psi_fired, mu_zero, forced_emission, &state,
-                        observer, user_data);
         }
     }
+    for (int j = 0; j < LIN_DIM; ++j) {
+        mpz_swap(m->a[dst][j], sum[j]);
+        mpz_clear(sum[j]);
+    }
+}
+
+#define LIN_BIT(reg) (1U << (reg))
+
+/* True if the koppa operation runs at this slot when psi never fires */
+static bool linear_koppa_triggers(const Config *config, const PlanSlot *slot) {
+    switch (config->koppa_trigger) {
+        case KOPPA_ON_MSTEP:
+            return slot->phase == 'M';
+        case KOPPA_ON_ALL_MU:
+            return slot->phase != 'E';
+        case KOPPA_ON_PSI:
+        case KOPPA_ON_MU_AFTER_PSI:
+        default:
+            /* Without psi, psi_recent is false whenever koppa_accrue reads it */
+            return false;
+    }
+}
+
+/* Check that no value-dependent branch can fire under this Config and
+ * count koppa stack pushes per tick. Returns false if the run must step. */
+static bool linear_config_admissible(const Config *config, const ExecutionPlan *plan,
+                                     size_t *pushes_per_tick) {
+    if (config->psi_mode == PSI_MODE_MSTEP ||
+        (!config->dual_track_mode && config->engine_mode == ENGINE_MODE_DELTA_ADD) ||
+        config->enable_stack_depth_modes ||
+        config->enable_koppa_gated_engine ||
+        config->enable_delta_cross_propagation ||
+        config->enable_beta_mod_koppa_wrap ||
+        config->enable_epsilon_phi_swap ||
+        config->sign_flip_mode != SIGN_FLIP_NONE) {
+        return false;
+    }
+    
+    size_t pushes = 0;
+    for (int i = 0; i < 11; ++i) {
+        const PlanSlot *slot = &plan->slot[i];
+        if (slot->phase == 'E' &&
+            (slot->ups_mode != ENGINE_TRACK_ADD || slot->beta_mode != ENGINE_TRACK_ADD)) {
+            return false;
+        }
+        /* Only ops that never set ρ (ratio checks merely request psi, which
+         * cannot fire without ρ outside PSI_MODE_MSTEP) */
+        for (int op = 0; op < slot->op_count; ++op) {
+            if (slot->ops[op] == op_pattern_new_upsilon ||
+                slot->ops[op] == op_pattern_memory ||
+                slot->ops[op] == op_forced_psi) {
+                return false;
+            }
+        }
+        if (slot->phase != 'E' && linear_koppa_triggers(config, slot)) {
+            if (config->koppa_mode == KOPPA_MODE_DUMP) {
+                return false;  /* κ collapses to 0/0 */
+            }
+            if (config->multi_level_koppa) {
+                pushes++;
+            }
+        }
+    }
+    
+    /* The stepped final tick must rewrite the whole stack */
+    if (pushes > 0 && pushes < config->koppa_stack_depth) {
+        return false;
+    }
+    *pushes_per_tick = pushes;
+    return true;
+}
+
+/* Positive integer registers: raw sums keep den 1 and never reach 0 */
+static bool linear_state_admissible(const TRTS_State *state) {
+    return !state->rho_pending &&
+           mpz_cmp_ui(state->upsilon.den, 1UL) == 0 && mpz_sgn(state->upsilon.num) > 0 &&
+           mpz_cmp_ui(state->beta.den, 1UL) == 0 && mpz_sgn(state->beta.num) > 0 &&
+           mpz_cmp_ui(state->koppa.den, 1UL) == 0 && mpz_sgn(state->koppa.num) > 0;
+}
+
+/* Build the one-tick map by replaying the plan's slots symbolically */
+static void linear_build_tick(const Config *config, const ExecutionPlan *plan,
+                              LinearMap *tick_map) {
+    linear_init_identity(tick_map);
+    for (int i = 0; i < 11; ++i) {
+        const PlanSlot *slot = &plan->slot[i];
+        if (slot->phase == 'E') {
+            /* ε = υ; υ' = υ + β + κ; β' = β + υ + κ (same raw integer) */
+            linear_assign(tick_map, LIN_E, LIN_BIT(LIN_U));
+            linear_assign(tick_map, LIN_U, LIN_BIT(LIN_U) | LIN_BIT(LIN_B) | LIN_BIT(LIN_K));
+            mpz_t *u_row = tick_map->a[LIN_U];
+            for (int j = 0; j < LIN_DIM; ++j) {
+                mpz_set(tick_map->a[LIN_B][j], u_row[j]);
+            }
+        } else if (linear_koppa_triggers(config, slot)) {
+            if (config->koppa_mode == KOPPA_MODE_POP) {
+                linear_assign(tick_map, LIN_K, LIN_BIT(LIN_E));
+            } else {
+                linear_assign(tick_map, LIN_K, LIN_BIT(LIN_K) | LIN_BIT(LIN_E));
+            }
+            linear_assign(tick_map, LIN_K, LIN_BIT(LIN_U) | LIN_BIT(LIN_B) | LIN_BIT(LIN_K));
+        }
+    }
+}
+
+/* Advance υ, β, κ by `ticks` ticks. Only υ/β/κ and the stack depth are
+ * carried across; ε, previous, deltas, sample and the stack contents are
+ * rewritten by the stepped tick that follows. */
+static void linear_fast_forward(const Config *config, const ExecutionPlan *plan,
+                                TRTS_State *state, size_t ticks,
+                                size_t pushes_per_tick) {
+    LinearMap base, power;
+    linear_build_tick(config, plan, &base);
+    linear_init_identity(&power);
+    
+    for (size_t n = ticks; n > 0; n >>= 1) {
+        if (n & 1) {
+            linear_mul(&power, &base, &power);
+        }
+        if (n > 1) {
+            linear_mul(&base, &base, &base);
+        }
+    }
+    
+    /* ε is dead at a tick boundary: the first E microtick overwrites it */
+    mpz_srcptr in[LIN_DIM] = {state->upsilon.num, state->beta.num,
+                              state->koppa.num, state->epsilon.num};
+    mpz_t out[3];
+    for (int i = 0; i < 3; ++i) {
+        mpz_init(out[i]);
+        for (int j = 0; j < LIN_DIM; ++j) {
+            if (j != LIN_E) {
+                mpz_addmul(out[i], power.a[i][j], in[j]);
+            }
+        }
+    }
+    mpz_swap(state->upsilon.num, out[LIN_U]);
+    mpz_swap(state->beta.num, out[LIN_B]);
+    mpz_swap(state->koppa.num, out[LIN_K]);
+    STATE_TOUCH(state, STATE_GEN_UPSILON);
+    STATE_TOUCH(state, STATE_GEN_BETA);
+    STATE_TOUCH(state, STATE_GEN_KOPPA);
+    for (int i = 0; i < 3; ++i) {
+        mpz_clear(out[i]);
+    }
+    
+    if (pushes_per_tick > 0) {
+        state->koppa_stack_size = state->koppa_stack_capacity;
+    }
+    
+    linear_clear(&base);
+    linear_clear(&power);
+}
+
+/* ========================================
+   MULTI-MODULAR LANES
+   ======================================== */
+
+/* Translate the plan into a residue-lane program. Ops that only set event
+ * flags are dropped; any op the lanes do not implement (pattern checks,
+ * ratio triggers, koppa sample hold) makes the plan inadmissible. */
+static bool multimod_compile(const ExecutionPlan *plan, MultimodProgram *program) {
+    for (int i = 0; i < 11; ++i) {
+        const PlanSlot *slot = &plan->slot[i];
+        MultimodSlot *lane = &program->slot[i];
+        lane->ups_mode = slot->ups_mode;
+        lane->beta_mode = slot->beta_mode;
+        lane->op_count = 0;
+        for (int op = 0; op < slot->op_count; ++op) {
+            PlanOp f = slot->ops[op];
+            MultimodOp m;
+            if (f == op_forced_emission || f == op_mu_zero) {
+                continue;
+            } else if (f == op_engine) {
+                m = MULTIMOD_OP_ENGINE;
+            } else if (f == op_forced_psi) {
+                m = MULTIMOD_OP_FORCED_PSI;
+            } else if (f == op_request_psi) {
+                m = MULTIMOD_OP_REQUEST_PSI;
+            } else if (f == op_request_psi_always) {
+                m = MULTIMOD_OP_REQUEST_PSI_ALWAYS;
+            } else if (f == op_psi_and_accrue) {
+                m = MULTIMOD_OP_PSI_AND_ACCRUE;
+            } else if (f == op_reset_accrue) {
+                m = MULTIMOD_OP_RESET_ACCRUE;
+            } else {
+                return false;
+            }
+            lane->ops[lane->op_count++] = m;
+        }
+    }
+    return true;
+}
+
+/* ========================================
+   RUNS
+   ======================================== */
+
+/* Run ticks 1..config->ticks of a reset state. Whole periods of an exact
+ * cycle are skipped when cycle detection is on. With final_only (no row
+ * before the last tick is wanted) the run may also go to the multi-modular
+ * lanes or the linear fast-forward; both leave the last tick to be
+ * stepped. Only stepped microticks reach outputs and observer.
+ * Returns the number of ticks not stepped in GMP. */
+static size_t run_ticks(const Config *config, const ExecutionPlan *plan,
+                        TRTS_State *state, bool final_only,
+                        const SimulationOutputs *outputs,
+                        SimulateObserver observer, void *user_data) {
+    size_t first = 1;
+    size_t skipped = 0;
+    
+    /* Residue lanes compute every tick but the last */
+    MultimodProgram program;
+    if (final_only && config->enable_multimodular_engine && config->ticks > 1 &&
+        multimod_compile(plan, &program) &&
+        multimod_final(config, &program, config->ticks - 1, state, NULL)) {
+        first = config->ticks;
+        skipped = config->ticks - 1;
+    }
+    
+    size_t pushes_per_tick = 0;
+    bool linear = final_only && linear_config_admissible(config, plan, &pushes_per_tick);
+    
+    CycleDetector cycle;
+    cycle_begin(&cycle, config, state);
+    
+    for (size_t tick = first; tick <= config->ticks; ++tick) {
+        /* Jump to the last tick, which is always stepped */
+        if (linear && skipped == 0 && tick < config->ticks &&
+            linear_state_admissible(state)) {
+            skipped = config->ticks - tick;
+            linear_fast_forward(config, plan, state, skipped, pushes_per_tick);
+            tick = config->ticks;
+        }
+        run_tick(plan, config, state, tick, outputs, observer, user_data);
+        
+        size_t period = cycle_observe(&cycle, state);
+        if (period > 0) {
+            tick = cycle_skip(config, state, tick, period, outputs, observer, user_data);
+            skipped += state->cycle_skipped_ticks;
+        }
+    }
+    
+    cycle_end(&cycle);
+    return skipped;
+}
+
+/* Run a reset state through every tick. File rows go to a writer thread
+ * unless Config.output_queue_rows is 0; the queue is started and finished
+ * inside the arena run, so its slot limbs are released with the arena. */
+static void run_simulation(const Config *config, const SimulationOutputs *files,
+                           SimulateObserver observer, void *user_data) {
+    if (config->enable_limb_arena) {
+        arena_run_begin();
+    }
+
+    SimulationOutputs queued;
+    const SimulationOutputs *outputs = files;
+    if (files && config->output_queue_rows > 0) {
+        queued = *files;
+        queued.queue = output_queue_start(config->output_queue_rows,
+                                          write_queued_row, (void *)files);
+        outputs = &queued;
+    }
+
+    ExecutionPlan plan;
+    plan_compile(config, &plan);
+
+    TRTS_State state;
+    state_init(&state);
+    state_reset(&state, config);
+    
+    /* An observer sees every microtick; files may only want the last */
+    bool final_only = !observer && config->output_final_only;
+    (void)run_ticks(config, &plan, &state, final_only, outputs, observer, user_data);
     
     state_clear(&state);
+    plan_clear(&plan);
+
+    if (outputs != files) {
+        /* Writes the last rows and frees the slots before the arena ends */
+        output_queue_finish(queued.queue);
+    }
+    if (files) {
+        quiet_flush(files);
+    }
+
+    if (config->enable_limb_arena) {
+        /* Scratch limbs were drawn from the arena; drop them before reset */
+        rational_scratch_release();
+        arena_run_end(NULL);
+    }
 }
 
 /* ========================================
@@ -508,43 +1136,65 @@ static void run_simulation(const Config *config, const SimulationOutputs *output
    ======================================== */
 
 void simulate(const Config *config) {
-    FILE *events_file = fopen("events.csv", "w");
-    if (!events_file) {
+    if (config->output_format == OUTPUT_FORMAT_BINARY) {
+        TraceWriter *trace = trace_writer_open("trace.bin", config);
+        if (!trace) {
+            perror("trace.bin");
+            return;
+        }
+        
+        SimulationOutputs sim_outputs = {NULL, NULL, trace, config, NULL, NULL};
+        run_simulation(config, &sim_outputs, NULL, NULL);
+        
+        if (!trace_writer_close(trace)) {
+            fprintf(stderr, "trace.bin: write failed\n");
+        }
+        return;
+    }
+    
+    CsvWriter *events = csv_writer_open("events.csv");
+    if (!events) {
         perror("events.csv");
         return;
     }
     
-    FILE *values_file = fopen("values.csv", "w");
-    if (!values_file) {
+    CsvWriter *values = csv_writer_open("values.csv");
+    if (!values) {
         perror("values.csv");
-        fclose(events_file);
+        csv_writer_close(events);
         return;
     }
     
-    /* Write CSV headers */
-    fprintf(events_file,
-            "tick,mt,phase,rho_event,psi_fired,mu_zero,forced_emission,"
-            "ratio_triggered,triple_psi,dual_engine,koppa_sample_index,"
-            "ratio_threshold,psi_strength,sign_flip\n");
+    /* Filtered output collapses quiet events.csv rows (rows column) */
+    QuietRun quiet = {false, 0, 0, '\0', 0, 0, 0};
+    bool filtered = config_output_filtered(config);
     
-    fprintf(values_file,
-            "tick,mt,upsilon_num,upsilon_den,beta_num,beta_den,koppa_num,koppa_den,"
-            "koppa_sample_num,koppa_sample_den,prev_upsilon_num,prev_upsilon_den,"
-            "prev_beta_num,prev_beta_den,koppa_stack0_num,koppa_stack0_den,"
-            "koppa_stack1_num,koppa_stack1_den,koppa_stack2_num,koppa_stack2_den,"
-            "koppa_stack3_num,koppa_stack3_den,koppa_stack_size,delta_upsilon_num,"
-            "delta_upsilon_den,delta_beta_num,delta_beta_den,triangle_phi_over_epsilon_num,"
-            "triangle_phi_over_epsilon_den,triangle_prev_over_phi_num,"
-            "triangle_prev_over_phi_den,triangle_epsilon_over_prev_num,"
-            "triangle_epsilon_over_prev_den\n");
+    /* Write CSV headers */
+    trace_write_csv_headers(events, values, trace_depth(config), filtered);
     
-    SimulationOutputs sim_outputs = {events_file, values_file};
+    SimulationOutputs sim_outputs = {events, values, NULL, config,
+                                     filtered ? &quiet : NULL, NULL};
     run_simulation(config, &sim_outputs, NULL, NULL);
     
-    fclose(events_file);
-    fclose(values_file);
+    if (!csv_writer_close(events)) {
+        fprintf(stderr, "events.csv: write failed\n");
+    }
+    if (!csv_writer_close(values)) {
+        fprintf(stderr, "values.csv: write failed\n");
+    }
 }
 
 void simulate_stream(const Config *config, SimulateObserver observer, void *user_data) {
     run_simulation(config, NULL, observer, user_data);
 }
+
+size_t simulate_final(const Config *config, TRTS_State *state) {
+    ExecutionPlan plan;
+    plan_compile(config, &plan);
+    state_reset(state, config);
+    
+    size_t skipped = run_ticks(config, &plan, state, true, NULL, NULL, NULL);
+    
+    plan_clear(&plan);
+    return skipped;
+}
@@ -37,20 +37,28 @@
  * - psi_fired: True if ψ transform was applied
  * - mu_zero: True if β numerator is zero
  * - forced_emission: True if this is microtick 10
+ *
+ * With cycle detection enabled, a detected cycle is reported once as a
+ * "cycle skipped" event: phase 'C', microtick 0, all flags false, tick set
+ * to the last skipped tick and state->cycle_period /
+ * state->cycle_skipped_ticks filled in. The state at that point equals the
+ * state after the skipped tick; microtick callbacks resume with tick + 1.
  */
 typedef void (*SimulateObserver)(void *user_data, size_t tick, int microtick, 
                                   char phase, const TRTS_State *state, 
                                   bool rho_event, bool psi_fired, 
                                   bool mu_zero, bool forced_emission);
 
-/* Run simulation and write events.csv and values.csv
+/* Run simulation and write events.csv and values.csv, or trace.bin
  *
  * This function executes a complete TRTS simulation with file output.
  * CSV files contain raw numerator/denominator values (no canonicalization).
  *
- * Files created:
- * - events.csv: Event flags per microtick
- * - values.csv: Raw rational values per microtick
+ * Files created (Config.output_format):
+ * - OUTPUT_FORMAT_CSV: events.csv (event flags per microtick) and
+ *   values.csv (raw rational values per microtick)
+ * - OUTPUT_FORMAT_BINARY: trace.bin, both in one binary columnar trace
+ *   (trace.h); trts_trace2csv converts it to the two CSV files
  */
 void simulate(const Config *config);
 
@@ -68,4 +76,24 @@ void simulate(const Config *config);
 void simulate_stream(const Config *config, SimulateObserver observer, 
                      void *user_data);
 
+/* Run simulation without per-microtick output and leave the final state
+ *
+ * state must be initialized (state_init); it is reset from config and
+ * holds the raw state after config->ticks ticks. When the config and the
+ * state admit it (ADD track modes, psi unable to fire, no wrap, sign flip,
+ * cross-propagation, triangle or koppa dump, and υ, β, κ positive
+ * integers), whole ticks are skipped by raising the per-tick integer
+ * matrix to a power. With the multi-modular engine enabled and an
+ * admissible config (see multimod.h), the ticks run on residue lanes
+ * instead. Both leave the last tick to be stepped. With cycle detection
+ * enabled, whole periods of an exact cycle are skipped too. The result is
+ * identical to stepping.
+ *
+ * simulate() takes the same path when Config.output_final_only is set.
+ *
+ * Returns: number of ticks not stepped in GMP (fast-forward, cycle
+ * skipping or residue lanes; 0 if fully stepped)
+ */
+size_t simulate_final(const Config *config, TRTS_State *state);
+
 #endif /* TRTS_SIMULATE_H */
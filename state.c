@@ -5,6 +5,46 @@
 
 #include "state.h"
 #include "config.h"
+#include <stdlib.h>
+
+/* Helper: give the koppa stack `capacity` fresh slots (head 0, empty).
+ * Aborts on allocation failure, matching GMP's own policy. */
+static void state_stack_allocate(TRTS_State *st, size_t capacity) {
+    st->koppa_stack = malloc(capacity * sizeof(Rational));
+    if (!st->koppa_stack) {
+        abort();
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        rational_init(&st->koppa_stack[i]);
+    }
+    st->koppa_stack_capacity = capacity;
+    st->koppa_stack_head = 0;
+    st->koppa_stack_size = 0;
+}
+
+static void state_stack_release(TRTS_State *st) {
+    for (size_t i = 0; i < st->koppa_stack_capacity; ++i) {
+        rational_clear(&st->koppa_stack[i]);
+    }
+    free(st->koppa_stack);
+    st->koppa_stack = NULL;
+    st->koppa_stack_capacity = 0;
+}
+
+/* Helper: resize the koppa stack (contents are discarded) */
+static void state_stack_resize(TRTS_State *st, size_t capacity) {
+    if (st->koppa_stack_capacity != capacity) {
+        state_stack_release(st);
+        state_stack_allocate(st, capacity);
+    }
+}
+
+/* Helper: count υ, β, κ as written */
+static void state_touch_all(TRTS_State *st) {
+    for (int r = 0; r < STATE_GEN_COUNT; ++r) {
+        STATE_TOUCH(st, r);
+    }
+}
 
 void state_init(TRTS_State *st) {
     /* Initialize all rational registers */
@@ -16,6 +56,8 @@ void state_init(TRTS_State *st) {
     
     rational_init(&st->previous_upsilon);
     rational_init(&st->previous_beta);
+    rational_init(&st->next_upsilon);
+    rational_init(&st->next_beta);
     rational_init(&st->delta_upsilon);
     rational_init(&st->delta_beta);
     
@@ -24,13 +66,11 @@ void state_init(TRTS_State *st) {
     rational_init(&st->triangle_epsilon_over_prev);
     
     /* Initialize koppa stack */
-    for (int i = 0; i < 4; ++i) {
-        rational_init(&st->koppa_stack[i]);
-    }
-    st->koppa_stack_size = 0;
+    state_stack_allocate(st, KOPPA_STACK_DEFAULT_DEPTH);
     
     rational_init(&st->koppa_sample);
     st->koppa_sample_index = -1;
+    st->koppa_sample_held = false;
     
     /* Initialize flags to false/zero */
     st->rho_pending = false;
@@ -43,7 +83,21 @@ void state_init(TRTS_State *st) {
     st->dual_engine_last_step = false;
     st->sign_flip_polarity = false;
     
+    /* Generations start at 1 so an empty memo (generation 0) never matches */
+    for (int r = 0; r < STATE_GEN_COUNT; ++r) {
+        st->generation[r] = 1;
+        st->pattern_memo[r].generation = 0;
+        st->pattern_memo[r].known = 0;
+        st->pattern_memo[r].found = 0;
+    }
+    st->ratio_memo.upsilon_generation = 0;
+    st->ratio_memo.beta_generation = 0;
+    st->ratio_memo.known = 0;
+    st->ratio_memo.found = 0;
+    
     st->tick = 0;
+    st->cycle_period = 0;
+    st->cycle_skipped_ticks = 0;
 }
 
 void state_clear(TRTS_State *st) {
@@ -56,6 +110,8 @@ void state_clear(TRTS_State *st) {
     
     rational_clear(&st->previous_upsilon);
     rational_clear(&st->previous_beta);
+    rational_clear(&st->next_upsilon);
+    rational_clear(&st->next_beta);
     rational_clear(&st->delta_upsilon);
     rational_clear(&st->delta_beta);
     
@@ -64,9 +120,7 @@ void state_clear(TRTS_State *st) {
     rational_clear(&st->triangle_epsilon_over_prev);
     
     /* Clear koppa stack */
-    for (int i = 0; i < 4; ++i) {
-        rational_clear(&st->koppa_stack[i]);
-    }
+    state_stack_release(st);
     
     rational_clear(&st->koppa_sample);
 }
@@ -76,6 +130,7 @@ void state_reset(TRTS_State *st, const Config *cfg) {
     rational_set(&st->upsilon, &cfg->initial_upsilon);
     rational_set(&st->beta, &cfg->initial_beta);
     rational_set(&st->koppa, &cfg->initial_koppa);
+    state_touch_all(st);
     
     /* Zero supplementary registers */
     rational_set_si(&st->epsilon, 0, 1);
@@ -95,13 +150,17 @@ void state_reset(TRTS_State *st, const Config *cfg) {
     rational_set_si(&st->triangle_epsilon_over_prev, 0, 1);
     
     /* Clear koppa stack */
+    state_stack_resize(st, cfg->koppa_stack_depth > 0 ? cfg->koppa_stack_depth : 1);
+    st->koppa_stack_head = 0;
     st->koppa_stack_size = 0;
-    for (int i = 0; i < 4; ++i) {
+    for (size_t i = 0; i < st->koppa_stack_capacity; ++i) {
         rational_set_si(&st->koppa_stack[i], 0, 1);
     }
     
+    /* The sample reads 0 until the first microtick samples */
     st->koppa_sample_index = -1;
     rational_set_si(&st->koppa_sample, 0, 1);
+    st->koppa_sample_held = true;
     
     /* Reset all flags */
     st->rho_pending = false;
@@ -115,4 +174,163 @@ void state_reset(TRTS_State *st, const Config *cfg) {
     st->sign_flip_polarity = false;
     
     st->tick = 0;
+    st->cycle_period = 0;
+    st->cycle_skipped_ticks = 0;
+}
+
+const Rational *state_koppa_sample(const TRTS_State *st) {
+    if (st->koppa_sample_held) {
+        return &st->koppa_sample;
+    }
+    if (st->koppa_sample_index >= 0) {
+        return KOPPA_STACK_ENTRY(st, st->koppa_sample_index);
+    }
+    return &st->koppa;
+}
+
+void state_hold_koppa_sample(TRTS_State *st) {
+    if (!st->koppa_sample_held) {
+        rational_set(&st->koppa_sample, state_koppa_sample(st));
+        st->koppa_sample_held = true;
+    }
+}
+
+/* Helper: visit the registers that make up the propagated state (the
+ * koppa stack entries are visited separately, in FIFO order; the sample
+ * is visited through its view) */
+#define STATE_REGISTER_COUNT 13
+
+static void state_registers(const TRTS_State *st, const Rational *regs[STATE_REGISTER_COUNT]) {
+    int n = 0;
+    regs[n++] = &st->upsilon;
+    regs[n++] = &st->beta;
+    regs[n++] = &st->koppa;
+    regs[n++] = &st->epsilon;
+    regs[n++] = &st->phi;
+    regs[n++] = &st->previous_upsilon;
+    regs[n++] = &st->previous_beta;
+    regs[n++] = &st->delta_upsilon;
+    regs[n++] = &st->delta_beta;
+    regs[n++] = &st->triangle_phi_over_epsilon;
+    regs[n++] = &st->triangle_prev_over_phi;
+    regs[n++] = &st->triangle_epsilon_over_prev;
+    regs[n++] = state_koppa_sample(st);
+}
+
+/* Helper: pack the flags into one word for comparison and hashing */
+static unsigned state_flag_bits(const TRTS_State *st) {
+    return (unsigned)st->rho_pending
+         | (unsigned)st->rho_latched << 1
+         | (unsigned)st->psi_recent << 2
+         | (unsigned)st->psi_triple_recent << 3
+         | (unsigned)st->psi_strength_applied << 4
+         | (unsigned)st->ratio_triggered_recent << 5
+         | (unsigned)st->ratio_threshold_recent << 6
+         | (unsigned)st->dual_engine_last_step << 7
+         | (unsigned)st->sign_flip_polarity << 8;
+}
+
+void state_copy(TRTS_State *dst, const TRTS_State *src) {
+    rational_set(&dst->upsilon, &src->upsilon);
+    rational_set(&dst->beta, &src->beta);
+    rational_set(&dst->koppa, &src->koppa);
+    state_touch_all(dst);
+    rational_set(&dst->epsilon, &src->epsilon);
+    rational_set(&dst->phi, &src->phi);
+    rational_set(&dst->previous_upsilon, &src->previous_upsilon);
+    rational_set(&dst->previous_beta, &src->previous_beta);
+    rational_set(&dst->delta_upsilon, &src->delta_upsilon);
+    rational_set(&dst->delta_beta, &src->delta_beta);
+    rational_set(&dst->triangle_phi_over_epsilon, &src->triangle_phi_over_epsilon);
+    rational_set(&dst->triangle_prev_over_phi, &src->triangle_prev_over_phi);
+    rational_set(&dst->triangle_epsilon_over_prev, &src->triangle_epsilon_over_prev);
+    if (src->koppa_sample_held) {
+        rational_set(&dst->koppa_sample, &src->koppa_sample);
+    }
+    
+    state_stack_resize(dst, src->koppa_stack_capacity);
+    for (size_t i = 0; i < src->koppa_stack_capacity; ++i) {
+        rational_set(&dst->koppa_stack[i], KOPPA_STACK_ENTRY(src, i));
+    }
+    dst->koppa_stack_head = 0;
+    dst->koppa_stack_size = src->koppa_stack_size;
+    dst->koppa_sample_index = src->koppa_sample_index;
+    dst->koppa_sample_held = src->koppa_sample_held;
+    dst->rho_pending = src->rho_pending;
+    dst->rho_latched = src->rho_latched;
+    dst->psi_recent = src->psi_recent;
+    dst->psi_triple_recent = src->psi_triple_recent;
+    dst->psi_strength_applied = src->psi_strength_applied;
+    dst->ratio_triggered_recent = src->ratio_triggered_recent;
+    dst->ratio_threshold_recent = src->ratio_threshold_recent;
+    dst->dual_engine_last_step = src->dual_engine_last_step;
+    dst->sign_flip_polarity = src->sign_flip_polarity;
+    dst->tick = src->tick;
+    dst->cycle_period = src->cycle_period;
+    dst->cycle_skipped_ticks = src->cycle_skipped_ticks;
+}
+
+bool state_equal(const TRTS_State *a, const TRTS_State *b) {
+    if (a->koppa_stack_capacity != b->koppa_stack_capacity ||
+        a->koppa_stack_size != b->koppa_stack_size ||
+        a->koppa_sample_index != b->koppa_sample_index ||
+        state_flag_bits(a) != state_flag_bits(b)) {
+        return false;
+    }
+    
+    const Rational *ra[STATE_REGISTER_COUNT];
+    const Rational *rb[STATE_REGISTER_COUNT];
+    state_registers(a, ra);
+    state_registers(b, rb);
+    for (int i = 0; i < STATE_REGISTER_COUNT; ++i) {
+        if (mpz_cmp(ra[i]->num, rb[i]->num) != 0 ||
+            mpz_cmp(ra[i]->den, rb[i]->den) != 0) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a->koppa_stack_capacity; ++i) {
+        const Rational *ea = KOPPA_STACK_ENTRY(a, i);
+        const Rational *eb = KOPPA_STACK_ENTRY(b, i);
+        if (mpz_cmp(ea->num, eb->num) != 0 || mpz_cmp(ea->den, eb->den) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Helper: fold one word into a running hash */
+static uint64_t hash_mix(uint64_t h, uint64_t word) {
+    h ^= word + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+/* Helper: fold an integer's sign, limb count and its lowest and highest
+ * limb. The cost stays constant as the registers grow; values that differ
+ * only in middle limbs collide and are told apart by state_equal. */
+static uint64_t hash_mpz(uint64_t h, mpz_srcptr z) {
+    size_t limbs = mpz_size(z);
+    h = hash_mix(h, (uint64_t)limbs << 2 | (uint64_t)(mpz_sgn(z) + 1));
+    if (limbs > 0) {
+        h = hash_mix(h, (uint64_t)mpz_getlimbn(z, 0));
+        h = hash_mix(h, (uint64_t)mpz_getlimbn(z, (mp_size_t)limbs - 1));
+    }
+    return h;
+}
+
+uint64_t state_hash(const TRTS_State *st) {
+    uint64_t h = 0;
+    const Rational *regs[STATE_REGISTER_COUNT];
+    state_registers(st, regs);
+    for (int i = 0; i < STATE_REGISTER_COUNT; ++i) {
+        h = hash_mpz(h, regs[i]->num);
+        h = hash_mpz(h, regs[i]->den);
+    }
+    for (size_t i = 0; i < st->koppa_stack_capacity; ++i) {
+        h = hash_mpz(h, KOPPA_STACK_ENTRY(st, i)->num);
+        h = hash_mpz(h, KOPPA_STACK_ENTRY(st, i)->den);
+    }
+    h = hash_mix(h, (uint64_t)st->koppa_stack_size);
+    h = hash_mix(h, (uint64_t)(int64_t)st->koppa_sample_index);
+    h = hash_mix(h, (uint64_t)state_flag_bits(st));
+    return h;
 }
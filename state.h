@@ -12,8 +12,32 @@
 #include "rational.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "config.h"
 
+/* Registers with write generations (the pattern-tested registers) */
+typedef enum {
+    STATE_GEN_UPSILON,
+    STATE_GEN_BETA,
+    STATE_GEN_KOPPA,
+    STATE_GEN_COUNT
+} StateGenerationRegister;
+
+/* Pattern results memoized for one register value (see pattern.h) */
+typedef struct {
+    uint64_t generation;                    /* Register generation described */
+    unsigned known;                         /* PATTERN_* tests already run */
+    unsigned found;                         /* PATTERN_* tests that passed */
+} PatternMemo;
+
+/* Ratio trigger results memoized for one (υ, β) pair (see simulate.c) */
+typedef struct {
+    uint64_t upsilon_generation;            /* Generations described */
+    uint64_t beta_generation;
+    unsigned known;                         /* Predicates already evaluated */
+    unsigned found;                         /* Predicates that held */
+} RatioMemo;
+
 /* Forward declaration 
 typedef struct Config_s Config;
 
@@ -25,8 +49,8 @@ TRTS Runtime State
  * - Previous values for delta computation
  * - Delta values (change from previous step)
  * - Triangle ratios (ε/φ relationships)
- * - Koppa stack (4-level FIFO for multi-level mode)
- * - Sample copy for stack selection
+ * - Koppa stack (FIFO ring for multi-level mode, default 4 levels)
+ * - Sample view for stack selection
  * - Flags for ρ, ψ, ratio triggers, engine modes
  * - Counters for stack size, sample index, tick number
  */
@@ -44,6 +68,11 @@ typedef struct {
     Rational previous_upsilon;
     Rational previous_beta;
     
+    /* Next-value slots: engine_step builds υ'/β' here and commits by
+     * rotating previous <- current <- next (contents otherwise unspecified) */
+    Rational next_upsilon;
+    Rational next_beta;
+    
     /* Delta values */
     Rational delta_upsilon;   /* Δυ = υ_current - υ_previous */
     Rational delta_beta;      /* Δβ = β_current - β_previous */
@@ -53,13 +82,22 @@ typedef struct {
     Rational triangle_prev_over_phi;        /* υ_prev/φ */
     Rational triangle_epsilon_over_prev;    /* ε/υ_prev */
     
-    /* Koppa stack (4 entries, FIFO) */
-    Rational koppa_stack[4];
-    size_t koppa_stack_size;                /* Current depth (0-4) */
+    /* Koppa stack: FIFO ring of koppa_stack_capacity slots (the configured
+     * depth). Entry i (0 = oldest) lives at slot (head + i) % capacity, see
+     * KOPPA_STACK_ENTRY; a push into a full ring overwrites the oldest
+     * slot and advances head. */
+    Rational *koppa_stack;
+    size_t koppa_stack_capacity;            /* Slots (Config.koppa_stack_depth) */
+    size_t koppa_stack_head;                /* Slot of the oldest entry */
+    size_t koppa_stack_size;                /* Current depth (0-capacity) */
     
-    /* Sample copy (selected from stack at specific microticks) */
+    /* Koppa sample: a view of the stack entry selected at specific
+     * microticks, or of κ. Resolve it with state_koppa_sample; the
+     * koppa_sample register only holds a value while koppa_sample_held
+     * is set (see state_hold_koppa_sample). */
     Rational koppa_sample;
-    int koppa_sample_index;                 /* Index of selected sample, or -1 */
+    int koppa_sample_index;                 /* Stack entry sampled (0 = oldest), or -1 */
+    bool koppa_sample_held;                 /* koppa_sample holds the sampled value */
     
     /* Flags */
     bool rho_pending;                       /* ρ event pending (trigger for ψ) */
@@ -72,18 +110,68 @@ typedef struct {
     bool dual_engine_last_step;             /* Dual-track engine used */
     bool sign_flip_polarity;                /* Sign-flip state */
     
+    /* Write generations of υ, β, κ, bumped by every write (STATE_TOUCH),
+     * and the pattern and ratio results memoized against them. Not part
+     * of the propagated state. */
+    uint64_t generation[STATE_GEN_COUNT];
+    PatternMemo pattern_memo[STATE_GEN_COUNT];
+    RatioMemo ratio_memo;
+    
     /* Tick counter */
     size_t tick;                            /* Current tick number (1-based) */
+    
+    /* Cycle detection (run metadata, not part of the propagated state) */
+    size_t cycle_period;                    /* Detected period in ticks, 0 if none */
+    size_t cycle_skipped_ticks;             /* Ticks skipped after detection */
 } TRTS_State;
 
-/* Initialize state structure (allocate all rationals, set to zero) */
+/* Koppa stack entry i (0 = oldest), i < koppa_stack_capacity */
+#define KOPPA_STACK_ENTRY(st, i) \
+    (&(st)->koppa_stack[((st)->koppa_stack_head + (size_t)(i)) % (st)->koppa_stack_capacity])
+
+/* Record a write to υ, β or κ; memoized pattern results of the previous
+ * value stop matching. Every writer of those registers must call it. */
+#define STATE_TOUCH(st, reg) ((void)++(st)->generation[reg])
+
+/* Resolve the koppa sample view: the held value, stack entry
+ * koppa_sample_index, or κ. The pointer is valid until κ or the stack
+ * next changes; consumers that need an owned value copy from it. */
+const Rational *state_koppa_sample(const TRTS_State *st);
+
+/* Copy the value the sample view refers to into koppa_sample, for use
+ * right before κ or the stack is overwritten in the same microtick */
+void state_hold_koppa_sample(TRTS_State *st);
+
+/* Initialize state structure (allocate all rationals, set to zero).
+ * The koppa stack gets KOPPA_STACK_DEFAULT_DEPTH slots. */
 void state_init(TRTS_State *st);
 
 /* Clear state structure (free all GMP resources) */
 void state_clear(TRTS_State *st);
 
 /* Reset state to initial configuration from Config
- * Loads seeds, zeroes flags, resets tick counter */
+ * Loads seeds, zeroes flags, resets tick counter and resizes the koppa
+ * stack to cfg->koppa_stack_depth slots */
 void state_reset(TRTS_State *st, const Config *cfg);
 
+/* Copy the propagated state of src into dst (both initialized).
+ * The next_* scratch slots are not copied; dst's koppa stack takes src's
+ * capacity with the oldest entry in slot 0. dst's υ, β, κ count as
+ * written. */
+void state_copy(TRTS_State *dst, const TRTS_State *src);
+
+/* Raw equality of the propagated state: every register component
+ * (mpz_cmp on numerators and denominators, no value equality; stack
+ * entries in FIFO order, whatever the ring head), the stack depth,
+ * sample index and flags. Ignores tick, cycle metadata and the
+ * next_* scratch slots. Two equal states at a tick boundary have
+ * identical futures. */
+bool state_equal(const TRTS_State *a, const TRTS_State *b);
+
+/* Cheap 64-bit hash over the same fields as state_equal. Each integer
+ * contributes its sign, size and lowest and highest limb only, so the cost
+ * does not grow with the registers. Equal states hash equal; a match must
+ * be confirmed with state_equal. */
+uint64_t state_hash(const TRTS_State *st);
+
 #endif /* TRTS_STATE_H */
@@ -0,0 +1,136 @@
+/* test_pattern_parallel.c - Parallel Pattern Checks Against Sequential
+ *
+ * Loads a mix of primes, Fibonacci numbers, perfect powers, products and
+ * random values into υ and runs pattern_test_any over every combination
+ * of PATTERN_* tests twice: on the parallel path (pattern_parallel_bits 1,
+ * four workers) and sequentially. The answers must agree, and each single
+ * test must agree afterwards, so results memoized by the workers are
+ * checked as well.
+ */
+
+#include "config.h"
+#include "pattern.h"
+#include "rational.h"
+#include "state.h"
+#include <gmp.h>
+#include <stdio.h>
+
+#define ALL_TESTS 0x3Fu                 /* Every PATTERN_* bit */
+#define VALUES 60
+
+/* A value of about bits bits: 0 prime, 1 Fibonacci, 2 cube, 3 product
+ * of two primes, 4 Fibonacci + 1, otherwise random */
+static void make_value(mpz_t value, int kind, unsigned long bits, gmp_randstate_t rng) {
+    switch (kind) {
+        case 0:
+            mpz_urandomb(value, rng, bits);
+            mpz_setbit(value, bits);
+            mpz_nextprime(value, value);
+            break;
+        case 1:
+            mpz_fib_ui(value, bits * 7 / 10 + 2);
+            break;
+        case 2:
+            mpz_urandomb(value, rng, bits / 3 + 2);
+            mpz_add_ui(value, value, 2);
+            mpz_pow_ui(value, value, 3);
+            break;
+        case 3: {
+            mpz_t factor;
+            mpz_init(factor);
+            mpz_urandomb(value, rng, bits / 2 + 2);
+            mpz_nextprime(value, value);
+            mpz_urandomb(factor, rng, bits / 2 + 2);
+            mpz_nextprime(factor, factor);
+            mpz_mul(value, value, factor);
+            mpz_clear(factor);
+            break;
+        }
+        case 4:
+            mpz_fib_ui(value, bits * 7 / 10 + 2);
+            mpz_add_ui(value, value, 1);
+            break;
+        default:
+            mpz_urandomb(value, rng, bits);
+            mpz_add_ui(value, value, 1);
+            break;
+    }
+}
+
+/* Helper: put num/den into υ as a fresh write */
+static void load(TRTS_State *st, mpz_srcptr num, mpz_srcptr den) {
+    rational_set_components(&st->upsilon, num, den);
+    STATE_TOUCH(st, STATE_GEN_UPSILON);
+}
+
+int main(void) {
+    Config sequential;
+    Config parallel;
+    config_init(&sequential);
+    config_init(&parallel);
+    sequential.pattern_parallel_bits = 0;
+    parallel.pattern_parallel_bits = 1;
+    parallel.pattern_threads = 4;
+
+    TRTS_State a;
+    TRTS_State b;
+    state_init(&a);
+    state_init(&b);
+    state_reset(&a, &sequential);
+    state_reset(&b, &parallel);
+
+    gmp_randstate_t rng;
+    gmp_randinit_default(rng);
+    gmp_randseed_ui(rng, 20);
+    mpz_t num;
+    mpz_t den;
+    mpz_init(num);
+    mpz_init(den);
+
+    int failures = 0;
+    int checks = 0;
+    for (int i = 0; i < VALUES && failures < 10; ++i) {
+        unsigned long bits = 8 + (unsigned long)(i * 37 % 1200);
+        make_value(num, i % 6, bits, rng);
+        make_value(den, (i / 6) % 6, bits / 2 + 8, rng);
+        if (i % 4 == 1) {
+            mpz_neg(num, num);
+        }
+
+        for (unsigned tests = 1; tests <= ALL_TESTS; ++tests) {
+            load(&a, num, den);
+            load(&b, num, den);
+            bool want = pattern_test_any(&sequential, &a, STATE_GEN_UPSILON, tests);
+            bool got = pattern_test_any(&parallel, &b, STATE_GEN_UPSILON, tests);
+            ++checks;
+            if (got != want) {
+                printf("FAIL value %d tests %02x: parallel %d, sequential %d\n",
+                       i, tests, got, want);
+                failures++;
+            }
+            for (unsigned test = 1; test <= ALL_TESTS; test <<= 1) {
+                if ((tests & test) &&
+                    pattern_test(&parallel, &b, STATE_GEN_UPSILON, test) !=
+                        pattern_test(&sequential, &a, STATE_GEN_UPSILON, test)) {
+                    printf("FAIL value %d test %02x: memoized result differs\n", i, test);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    mpz_clear(num);
+    mpz_clear(den);
+    gmp_randclear(rng);
+    state_clear(&a);
+    state_clear(&b);
+    config_clear(&sequential);
+    config_clear(&parallel);
+
+    if (failures > 0) {
+        printf("%d failure(s)\n", failures);
+        return 1;
+    }
+    printf("ok   %d test combinations agree\n", checks);
+    return 0;
+}
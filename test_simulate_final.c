@@ -0,0 +1,183 @@
+/* test_simulate_final.c - simulate_final Against Stepping
+ *
+ * Runs each configuration twice: stepped microtick by microtick through
+ * simulate_stream, and through simulate_final. The final states must be
+ * identical on every raw component, and configurations built to admit a
+ * shortcut must actually take it. The multi-modular cases rebuild the
+ * state by Chinese remaindering from the residue lanes, so they compare
+ * the lane interpreter with the GMP engine, psi and koppa steps.
+ */
+
+#include "config.h"
+#include "rational.h"
+#include "simulate.h"
+#include "state.h"
+#include <stdio.h>
+
+/* Shortcut a configuration is built to take */
+typedef enum {
+    EXPECT_STEPPED,             /* Every tick stepped */
+    EXPECT_SKIP,                /* Some ticks skipped */
+    EXPECT_ALL_BUT_LAST         /* Every tick but the last skipped */
+} Expect;
+
+typedef struct {
+    size_t ticks;
+    TRTS_State *final;
+} FinalCapture;
+
+/* SimulateObserver: keep the state after the last microtick */
+static void capture_final(void *user_data, size_t tick, int microtick,
+                          char phase, const TRTS_State *state,
+                          bool rho_event, bool psi_fired,
+                          bool mu_zero, bool forced_emission) {
+    FinalCapture *capture = user_data;
+    (void)phase;
+    (void)rho_event;
+    (void)psi_fired;
+    (void)mu_zero;
+    (void)forced_emission;
+    if (tick == capture->ticks && microtick == 11) {
+        state_copy(capture->final, state);
+    }
+}
+
+/* Linear fast-forward admissible: ADD tracks, integer seeds, psi only on
+ * ρ and nothing that sets ρ (no pattern op for delta targets, no forced
+ * psi at MT10) */
+static void linear_config(Config *config, size_t ticks) {
+    config_init(config);
+    config->ticks = ticks;
+    config->psi_mode = PSI_MODE_RHO_ONLY;
+    config->mt10_behavior = MT10_NONE;
+    config->prime_target = PRIME_ON_DELTA;
+    rational_set_si(&config->initial_upsilon, 3, 1);
+    rational_set_si(&config->initial_beta, 5, 1);
+    rational_set_si(&config->initial_koppa, 1, 1);
+}
+
+/* Residue lanes over two ticks (the second is stepped); ρ comes only
+ * from forced psi, so the plan has no pattern op */
+static void lanes_config(Config *config) {
+    linear_config(config, 2);
+    config->enable_multimodular_engine = true;
+    config->multimodular_threads = 2;
+    config->multi_level_koppa = true;
+}
+
+static int check(const char *name, const Config *config, Expect expect) {
+    TRTS_State stepped;
+    TRTS_State final;
+    state_init(&stepped);
+    state_init(&final);
+    state_reset(&stepped, config);
+
+    FinalCapture capture = {config->ticks, &stepped};
+    simulate_stream(config, capture_final, &capture);
+    size_t skipped = simulate_final(config, &final);
+
+    int failures = 0;
+    if (!state_equal(&stepped, &final)) {
+        printf("FAIL %s: final state differs from stepping\n", name);
+        failures++;
+    } else if ((expect == EXPECT_STEPPED && skipped != 0) ||
+               (expect == EXPECT_SKIP && skipped == 0) ||
+               (expect == EXPECT_ALL_BUT_LAST && skipped != config->ticks - 1)) {
+        printf("FAIL %s: %zu of %zu ticks skipped\n", name, skipped, config->ticks);
+        failures++;
+    } else {
+        printf("ok   %s (%zu of %zu ticks skipped)\n", name, skipped, config->ticks);
+    }
+
+    state_clear(&stepped);
+    state_clear(&final);
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+    Config config;
+
+    linear_config(&config, 40);
+    failures += check("linear accumulate", &config, EXPECT_SKIP);
+    config_clear(&config);
+
+    linear_config(&config, 40);
+    config.koppa_mode = KOPPA_MODE_POP;
+    failures += check("linear pop", &config, EXPECT_SKIP);
+    config_clear(&config);
+
+    linear_config(&config, 40);
+    config.multi_level_koppa = true;
+    failures += check("linear koppa stack", &config, EXPECT_SKIP);
+    config_clear(&config);
+
+    linear_config(&config, 40);
+    config.multi_level_koppa = true;
+    config.koppa_trigger = KOPPA_ON_MSTEP;
+    failures += check("linear stack on M steps", &config, EXPECT_SKIP);
+    config_clear(&config);
+
+    linear_config(&config, 40);
+    config.dual_track_mode = true;
+    config.prime_target = PRIME_ON_KOPPA;
+    failures += check("linear dual track", &config, EXPECT_SKIP);
+    config_clear(&config);
+
+    /* Not admissible: psi fires on every M step, every tick is stepped */
+    config_init(&config);
+    config.ticks = 3;
+    failures += check("stepped default", &config, EXPECT_STEPPED);
+    config_clear(&config);
+
+    linear_config(&config, 40);
+    config.enable_multimodular_engine = true;
+    config.multi_level_koppa = true;
+    failures += check("lanes without psi", &config, EXPECT_ALL_BUT_LAST);
+    config_clear(&config);
+
+    lanes_config(&config);
+    config.mt10_behavior = MT10_FORCED_PSI;
+    failures += check("lanes forced psi", &config, EXPECT_ALL_BUT_LAST);
+    config_clear(&config);
+
+    lanes_config(&config);
+    config.mt10_behavior = MT10_FORCED_PSI;
+    config.triple_psi_mode = true;
+    failures += check("lanes forced triple psi", &config, EXPECT_ALL_BUT_LAST);
+    config_clear(&config);
+
+    lanes_config(&config);
+    config.psi_mode = PSI_MODE_MSTEP_RHO;
+    config.enable_stack_depth_modes = true;
+    failures += check("lanes stack depth modes", &config, EXPECT_ALL_BUT_LAST);
+    config_clear(&config);
+
+    lanes_config(&config);
+    config.psi_mode = PSI_MODE_INHIBIT_RHO;
+    config.enable_stack_depth_modes = true;
+    failures += check("lanes inhibit rho", &config, EXPECT_ALL_BUT_LAST);
+    config_clear(&config);
+
+    lanes_config(&config);
+    config.psi_mode = PSI_MODE_MSTEP;
+    config.triple_psi_mode = true;
+    config.multi_level_koppa = false;
+    config.koppa_mode = KOPPA_MODE_POP;
+    config.koppa_trigger = KOPPA_ON_MSTEP;
+    failures += check("lanes triple psi on M steps", &config, EXPECT_ALL_BUT_LAST);
+    config_clear(&config);
+
+    /* The new-υ pattern op sets ρ, so the plan must not go to the lanes */
+    lanes_config(&config);
+    config.mt10_behavior = MT10_FORCED_PSI;
+    config.prime_target = PRIME_ON_CURRENT;
+    failures += check("lanes refuse pattern ops", &config, EXPECT_STEPPED);
+    config_clear(&config);
+
+    if (failures > 0) {
+        printf("%d failure(s)\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,649 @@
+/* trace.c - Binary Columnar Run Traces Implementation
+ *
+ * The writer keeps one growable byte buffer per column and appends each
+ * row's entries to them; a full chunk is written column after column.
+ * Integers are exported into a per-column scratch buffer and compared
+ * with the column's previous entry, which is kept encoded, so repeats cost
+ * one memcmp. All buffers are malloc'd, never drawn from GMP.
+ */
+
+#include "trace.h"
+#include "rational.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char trace_magic[8] = "TRTSTRC";
+static const char trace_phases[] = "EMRC";
+
+/* Scalar columns ahead of the integers */
+enum { COL_TICK, COL_MICROTICK, COL_FLAGS, COL_SAMPLE, COL_STACK_SIZE, COL_SCALARS };
+
+/* Longest varint of a size_t (7 bits per byte) */
+#define VARINT_MAX ((sizeof(size_t) * 8 + 6) / 7)
+
+typedef struct {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+} TraceBuffer;
+
+struct TraceWriter {
+    FILE *file;
+    size_t depth;
+    size_t rows;                        /* Rows in the current chunk */
+    size_t bytes;                       /* Integer bytes buffered in the chunk */
+    size_t last_tick;
+    bool failed;
+    TraceBuffer scalar[COL_SCALARS];
+    TraceBuffer *value;                 /* TRACE_VALUE_COLUMNS(depth) columns */
+    TraceBuffer *previous;              /* Last entry of each, encoded */
+    TraceBuffer *scratch;               /* Entry being encoded, swapped with previous */
+};
+
+struct TraceReader {
+    FILE *file;
+    size_t depth;
+    char *config;
+    bool failed;
+    bool done;
+    size_t rows;                        /* Rows in the current chunk */
+    size_t row;                         /* Rows decoded from it */
+    TraceBuffer column[COL_SCALARS];
+    TraceBuffer *value;
+    size_t cursor[COL_SCALARS];
+    size_t *value_cursor;
+    TraceRow current;
+};
+
+/* Helper: abort on allocation failure, matching GMP's own policy */
+static void *checked(void *ptr) {
+    if (!ptr) {
+        abort();
+    }
+    return ptr;
+}
+
+static void buffer_reserve(TraceBuffer *buf, size_t extra) {
+    if (buf->cap - buf->len >= extra) {
+        return;
+    }
+    size_t cap = buf->cap > 0 ? buf->cap : 64;
+    while (cap - buf->len < extra) {
+        cap *= 2;
+    }
+    buf->data = checked(realloc(buf->data, cap));
+    buf->cap = cap;
+}
+
+static void buffer_free(TraceBuffer *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = buf->cap = 0;
+}
+
+/* Helper: LEB128-encode value at out; returns the byte count */
+static size_t varint_encode(unsigned char *out, size_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (unsigned char)value;
+    return n;
+}
+
+static void buffer_put_varint(TraceBuffer *buf, size_t value) {
+    buffer_reserve(buf, VARINT_MAX);
+    buf->len += varint_encode(buf->data + buf->len, value);
+}
+
+static void buffer_put_byte(TraceBuffer *buf, unsigned char byte) {
+    buffer_reserve(buf, 1);
+    buf->data[buf->len++] = byte;
+}
+
+/* Helper: store the low nbits of bits at bit offset pos (LSB first) */
+static void buffer_put_bits(TraceBuffer *buf, size_t pos, unsigned bits, int nbits) {
+    size_t need = (pos + (size_t)nbits + 7) / 8;
+    if (need > buf->len) {
+        buffer_reserve(buf, need - buf->len);
+        memset(buf->data + buf->len, 0, need - buf->len);
+        buf->len = need;
+    }
+    for (int i = 0; i < nbits; ++i, ++pos) {
+        if (bits & (1u << i)) {
+            buf->data[pos / 8] |= (unsigned char)(1u << (pos % 8));
+        }
+    }
+}
+
+static bool varint_read(const TraceBuffer *buf, size_t *cursor, size_t *value) {
+    size_t result = 0;
+    for (unsigned shift = 0; shift < sizeof(size_t) * 8; shift += 7) {
+        if (*cursor >= buf->len) {
+            return false;
+        }
+        unsigned char byte = buf->data[(*cursor)++];
+        result |= (size_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool file_read_varint(FILE *file, size_t *value) {
+    size_t result = 0;
+    for (unsigned shift = 0; shift < sizeof(size_t) * 8; shift += 7) {
+        int byte = fgetc(file);
+        if (byte == EOF) {
+            return false;
+        }
+        result |= (size_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void file_write_varint(TraceWriter *writer, size_t value) {
+    unsigned char out[VARINT_MAX];
+    size_t n = varint_encode(out, value);
+    if (fwrite(out, 1, n, writer->file) != n) {
+        writer->failed = true;
+    }
+}
+
+/* ========================================
+   CSV HEADERS
+   ======================================== */
+
+size_t trace_depth(const Config *config) {
+    return config->koppa_stack_depth > 0 ? config->koppa_stack_depth : 1;
+}
+
+void trace_write_csv_headers(CsvWriter *events, CsvWriter *values, size_t depth,
+                             bool row_counts) {
+    if (events) {
+        csv_writer_text(events,
+                "tick,mt,phase,rho_event,psi_fired,mu_zero,forced_emission,"
+                "ratio_triggered,triple_psi,dual_engine,koppa_sample_index,"
+                "ratio_threshold,psi_strength,sign_flip");
+        csv_writer_text(events, row_counts ? ",rows\n" : "\n");
+    }
+    if (values) {
+        csv_writer_text(values,
+                "tick,mt,upsilon_num,upsilon_den,beta_num,beta_den,koppa_num,koppa_den,"
+                "koppa_sample_num,koppa_sample_den,prev_upsilon_num,prev_upsilon_den,"
+                "prev_beta_num,prev_beta_den,");
+        char column[96];
+        for (size_t i = 0; i < depth; ++i) {
+            snprintf(column, sizeof(column), "koppa_stack%zu_num,koppa_stack%zu_den,", i, i);
+            csv_writer_text(values, column);
+        }
+        csv_writer_text(values,
+                "koppa_stack_size,delta_upsilon_num,"
+                "delta_upsilon_den,delta_beta_num,delta_beta_den,triangle_phi_over_epsilon_num,"
+                "triangle_phi_over_epsilon_den,triangle_prev_over_phi_num,"
+                "triangle_prev_over_phi_den,triangle_epsilon_over_prev_num,"
+                "triangle_epsilon_over_prev_den\n");
+    }
+}
+
+/* ========================================
+   WRITER
+   ======================================== */
+
+/* Helper: one "field=N/D" header line */
+static void header_rational(FILE *file, const char *field, const Rational *value) {
+    fprintf(file, "%s=", field);
+    mpz_out_str(file, 10, value->num);
+    fputc('/', file);
+    mpz_out_str(file, 10, value->den);
+    fputc('\n', file);
+}
+
+/* Helper: the Config as "field=value" lines (enums as numbers) */
+static void header_config(FILE *file, const Config *c) {
+    fprintf(file,
+            "engine_mode=%d\nengine_upsilon=%d\nengine_beta=%d\npsi_mode=%d\n"
+            "koppa_mode=%d\nkoppa_trigger=%d\nprime_target=%d\nmt10_behavior=%d\n"
+            "sign_flip_mode=%d\nratio_trigger_mode=%d\noutput_format=%d\n",
+            (int)c->engine_mode, (int)c->engine_upsilon, (int)c->engine_beta,
+            (int)c->psi_mode, (int)c->koppa_mode, (int)c->koppa_trigger,
+            (int)c->prime_target, (int)c->mt10_behavior, (int)c->sign_flip_mode,
+            (int)c->ratio_trigger_mode, (int)c->output_format);
+
+    const struct {
+        const char *field;
+        bool value;
+    } flags[] = {
+        {"dual_track_mode", c->dual_track_mode},
+        {"triple_psi_mode", c->triple_psi_mode},
+        {"multi_level_koppa", c->multi_level_koppa},
+        {"enable_asymmetric_cascade", c->enable_asymmetric_cascade},
+        {"enable_conditional_triple_psi", c->enable_conditional_triple_psi},
+        {"enable_koppa_gated_engine", c->enable_koppa_gated_engine},
+        {"enable_delta_cross_propagation", c->enable_delta_cross_propagation},
+        {"enable_delta_koppa_offset", c->enable_delta_koppa_offset},
+        {"enable_ratio_threshold_psi", c->enable_ratio_threshold_psi},
+        {"enable_stack_depth_modes", c->enable_stack_depth_modes},
+        {"enable_epsilon_phi_swap", c->enable_epsilon_phi_swap},
+        {"enable_beta_mod_koppa_wrap", c->enable_beta_mod_koppa_wrap},
+        {"enable_psi_strength_parameter", c->enable_psi_strength_parameter},
+        {"enable_ratio_custom_range", c->enable_ratio_custom_range},
+        {"enable_twin_prime_trigger", c->enable_twin_prime_trigger},
+        {"enable_fibonacci_trigger", c->enable_fibonacci_trigger},
+        {"enable_perfect_power_trigger", c->enable_perfect_power_trigger},
+        {"enable_ratio_snapshot_logging", c->enable_ratio_snapshot_logging},
+        {"enable_feedback_oscillator", c->enable_feedback_oscillator},
+        {"enable_fibonacci_gate", c->enable_fibonacci_gate},
+        {"enable_limb_arena", c->enable_limb_arena},
+        {"enable_cycle_detection", c->enable_cycle_detection},
+        {"enable_multimodular_engine", c->enable_multimodular_engine},
+        {"prime_too_large_is_prime", c->prime_too_large_is_prime}
+    };
+    for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); ++i) {
+        fprintf(file, "%s=%d\n", flags[i].field, flags[i].value ? 1 : 0);
+    }
+
+    fprintf(file,
+            "ticks=%zu\nmultimodular_threads=%u\nkoppa_stack_depth=%zu\n"
+            "prime_test_reps=%d\nprime_test_max_bits=%zu\npattern_threads=%u\n"
+            "pattern_parallel_bits=%zu\nkoppa_wrap_threshold=%lu\n"
+            "output_every=%zu\noutput_tick_from=%zu\noutput_tick_to=%zu\n"
+            "output_events=%u\noutput_final_only=%d\noutput_queue_rows=%zu\n",
+            c->ticks, c->multimodular_threads, c->koppa_stack_depth,
+            c->prime_test_reps, c->prime_test_max_bits, c->pattern_threads,
+            c->pattern_parallel_bits, c->koppa_wrap_threshold,
+            c->output_every, c->output_tick_from, c->output_tick_to,
+            c->output_events, c->output_final_only ? 1 : 0, c->output_queue_rows);
+    header_rational(file, "initial_upsilon", &c->initial_upsilon);
+    header_rational(file, "initial_beta", &c->initial_beta);
+    header_rational(file, "initial_koppa", &c->initial_koppa);
+    header_rational(file, "ratio_custom_lower", &c->ratio_custom_lower);
+    header_rational(file, "ratio_custom_upper", &c->ratio_custom_upper);
+    fputs("modulus_bound=", file);
+    mpz_out_str(file, 10, c->modulus_bound);
+    fputc('\n', file);
+}
+
+TraceWriter *trace_writer_open(const char *path, const Config *config) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return NULL;
+    }
+
+    TraceWriter *writer = checked(calloc(1, sizeof(TraceWriter)));
+    writer->file = file;
+    writer->depth = trace_depth(config);
+    size_t columns = TRACE_VALUE_COLUMNS(writer->depth);
+    writer->value = checked(calloc(columns, sizeof(TraceBuffer)));
+    writer->previous = checked(calloc(columns, sizeof(TraceBuffer)));
+    writer->scratch = checked(calloc(columns, sizeof(TraceBuffer)));
+
+    fwrite(trace_magic, 1, sizeof(trace_magic), file);
+    file_write_varint(writer, TRACE_VERSION);
+    file_write_varint(writer, writer->depth);
+    header_config(file, config);
+    fputc('\0', file);
+    if (ferror(file)) {
+        writer->failed = true;
+    }
+    return writer;
+}
+
+/* Helper: write the buffered chunk and start a new one */
+static void writer_flush(TraceWriter *writer) {
+    if (writer->rows == 0) {
+        return;
+    }
+    size_t columns = TRACE_VALUE_COLUMNS(writer->depth);
+    file_write_varint(writer, writer->rows);
+    for (size_t c = 0; c < COL_SCALARS + columns; ++c) {
+        TraceBuffer *buf = c < COL_SCALARS ? &writer->scalar[c]
+                                           : &writer->value[c - COL_SCALARS];
+        file_write_varint(writer, buf->len);
+        if (buf->len > 0 && fwrite(buf->data, 1, buf->len, writer->file) != buf->len) {
+            writer->failed = true;
+        }
+        buf->len = 0;
+    }
+    /* Chunks decode independently: no entry may repeat across them */
+    for (size_t c = 0; c < columns; ++c) {
+        writer->previous[c].len = 0;
+    }
+    writer->rows = 0;
+    writer->bytes = 0;
+    writer->last_tick = 0;
+}
+
+/* Helper: append integer z to column c */
+static void writer_put_integer(TraceWriter *writer, size_t c, mpz_srcptr z) {
+    TraceBuffer *scratch = &writer->scratch[c];
+    TraceBuffer *previous = &writer->previous[c];
+    size_t n = mpz_sgn(z) == 0 ? 0 : (mpz_sizeinbase(z, 2) + 7) / 8;
+
+    scratch->len = 0;
+    buffer_reserve(scratch, VARINT_MAX + n);
+    if (n == 0) {
+        scratch->len = varint_encode(scratch->data, 0);
+    } else {
+        scratch->len = varint_encode(scratch->data,
+                                     2 + 2 * n + (mpz_sgn(z) < 0 ? 1 : 0));
+        size_t count = 0;
+        mpz_export(scratch->data + scratch->len, &count, -1, 1, 0, 0, z);
+        scratch->len += count;
+    }
+
+    TraceBuffer *out = &writer->value[c];
+    if (scratch->len == previous->len &&
+        memcmp(scratch->data, previous->data, scratch->len) == 0) {
+        buffer_put_varint(out, 1);
+        writer->bytes += 1;
+        return;
+    }
+    buffer_reserve(out, scratch->len);
+    memcpy(out->data + out->len, scratch->data, scratch->len);
+    out->len += scratch->len;
+    writer->bytes += scratch->len;
+
+    /* The new entry becomes the one to repeat */
+    TraceBuffer swap = *previous;
+    *previous = *scratch;
+    *scratch = swap;
+}
+
+static void writer_put_rational(TraceWriter *writer, size_t *c, const Rational *value) {
+    writer_put_integer(writer, (*c)++, value->num);
+    writer_put_integer(writer, (*c)++, value->den);
+}
+
+void trace_writer_row(TraceWriter *writer, size_t tick, int microtick, char phase,
+                      bool rho_event, bool psi_fired, bool mu_zero,
+                      bool forced_emission, const TRTS_State *state) {
+    const char *code = phase != '\0' ? strchr(trace_phases, phase) : NULL;
+    unsigned phase_code = code ? (unsigned)(code - trace_phases) : 3u;
+    unsigned flags =
+        (rho_event ? TRACE_FLAG_RHO_EVENT : 0) |
+        (psi_fired ? TRACE_FLAG_PSI_FIRED : 0) |
+        (mu_zero ? TRACE_FLAG_MU_ZERO : 0) |
+        (forced_emission ? TRACE_FLAG_FORCED_EMISSION : 0) |
+        (state->ratio_triggered_recent ? TRACE_FLAG_RATIO_TRIGGERED : 0) |
+        (state->psi_triple_recent ? TRACE_FLAG_TRIPLE_PSI : 0) |
+        (state->dual_engine_last_step ? TRACE_FLAG_DUAL_ENGINE : 0) |
+        (state->ratio_threshold_recent ? TRACE_FLAG_RATIO_THRESHOLD : 0) |
+        (state->psi_strength_applied ? TRACE_FLAG_PSI_STRENGTH : 0) |
+        (state->sign_flip_polarity ? TRACE_FLAG_SIGN_FLIP : 0);
+
+    buffer_put_varint(&writer->scalar[COL_TICK], tick - writer->last_tick);
+    writer->last_tick = tick;
+    buffer_put_byte(&writer->scalar[COL_MICROTICK],
+                    (unsigned char)((unsigned)microtick | phase_code << 4));
+    buffer_put_bits(&writer->scalar[COL_FLAGS], writer->rows * TRACE_FLAG_BITS,
+                    flags, TRACE_FLAG_BITS);
+    buffer_put_varint(&writer->scalar[COL_SAMPLE],
+                      (size_t)(state->koppa_sample_index + 1));
+    buffer_put_varint(&writer->scalar[COL_STACK_SIZE], state->koppa_stack_size);
+
+    size_t c = 0;
+    writer_put_rational(writer, &c, &state->upsilon);
+    writer_put_rational(writer, &c, &state->beta);
+    writer_put_rational(writer, &c, &state->koppa);
+    writer_put_rational(writer, &c, state_koppa_sample(state));
+    writer_put_rational(writer, &c, &state->previous_upsilon);
+    writer_put_rational(writer, &c, &state->previous_beta);
+    for (size_t i = 0; i < writer->depth; ++i) {
+        writer_put_rational(writer, &c, KOPPA_STACK_ENTRY(state, i));
+    }
+    writer_put_rational(writer, &c, &state->delta_upsilon);
+    writer_put_rational(writer, &c, &state->delta_beta);
+    writer_put_rational(writer, &c, &state->triangle_phi_over_epsilon);
+    writer_put_rational(writer, &c, &state->triangle_prev_over_phi);
+    writer_put_rational(writer, &c, &state->triangle_epsilon_over_prev);
+
+    if (++writer->rows == TRACE_CHUNK_ROWS || writer->bytes >= TRACE_CHUNK_BYTES) {
+        writer_flush(writer);
+    }
+}
+
+bool trace_writer_close(TraceWriter *writer) {
+    if (!writer) {
+        return false;
+    }
+    writer_flush(writer);
+    file_write_varint(writer, 0);
+    bool ok = !writer->failed && !ferror(writer->file);
+    if (fclose(writer->file) != 0) {
+        ok = false;
+    }
+
+    size_t columns = TRACE_VALUE_COLUMNS(writer->depth);
+    for (size_t c = 0; c < COL_SCALARS; ++c) {
+        buffer_free(&writer->scalar[c]);
+    }
+    for (size_t c = 0; c < columns; ++c) {
+        buffer_free(&writer->value[c]);
+        buffer_free(&writer->previous[c]);
+        buffer_free(&writer->scratch[c]);
+    }
+    free(writer->value);
+    free(writer->previous);
+    free(writer->scratch);
+    free(writer);
+    return ok;
+}
+
+/* ========================================
+   READER
+   ======================================== */
+
+static void write_error(char *buffer, size_t capacity, const char *message) {
+    if (buffer && capacity > 0) {
+        snprintf(buffer, capacity, "%s", message);
+    }
+}
+
+TraceReader *trace_reader_open(const char *path, char *error_buffer,
+                               size_t error_capacity) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        write_error(error_buffer, error_capacity, strerror(errno));
+        return NULL;
+    }
+
+    char magic[sizeof(trace_magic)];
+    size_t version = 0, depth = 0;
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, trace_magic, sizeof(magic)) != 0) {
+        write_error(error_buffer, error_capacity, "Not a TRTS trace");
+        fclose(file);
+        return NULL;
+    }
+    if (!file_read_varint(file, &version) || version != TRACE_VERSION) {
+        write_error(error_buffer, error_capacity, "Unsupported trace version");
+        fclose(file);
+        return NULL;
+    }
+    if (!file_read_varint(file, &depth) || depth == 0 || depth > KOPPA_STACK_MAX_DEPTH) {
+        write_error(error_buffer, error_capacity, "Invalid koppa stack depth");
+        fclose(file);
+        return NULL;
+    }
+
+    /* Config text up to its zero byte */
+    TraceBuffer text = {NULL, 0, 0};
+    int ch;
+    while ((ch = fgetc(file)) != EOF && ch != '\0') {
+        buffer_put_byte(&text, (unsigned char)ch);
+    }
+    if (ch == EOF) {
+        write_error(error_buffer, error_capacity, "Truncated trace header");
+        buffer_free(&text);
+        fclose(file);
+        return NULL;
+    }
+    buffer_put_byte(&text, '\0');
+
+    TraceReader *reader = checked(calloc(1, sizeof(TraceReader)));
+    reader->file = file;
+    reader->depth = depth;
+    reader->config = (char *)text.data;
+    size_t columns = TRACE_VALUE_COLUMNS(depth);
+    reader->value = checked(calloc(columns, sizeof(TraceBuffer)));
+    reader->value_cursor = checked(calloc(columns, sizeof(size_t)));
+    reader->current.value = checked(malloc(columns * sizeof(mpz_t)));
+    for (size_t c = 0; c < columns; ++c) {
+        mpz_init(reader->current.value[c]);
+    }
+    return reader;
+}
+
+const char *trace_reader_config(const TraceReader *reader) {
+    return reader->config;
+}
+
+size_t trace_reader_depth(const TraceReader *reader) {
+    return reader->depth;
+}
+
+bool trace_reader_failed(const TraceReader *reader) {
+    return reader->failed;
+}
+
+/* Helper: read the next chunk's columns; false at the end or on error */
+static bool reader_load_chunk(TraceReader *reader) {
+    size_t rows = 0;
+    if (!file_read_varint(reader->file, &rows)) {
+        reader->failed = true;
+        return false;
+    }
+    if (rows == 0) {
+        reader->done = true;
+        return false;
+    }
+
+    size_t columns = TRACE_VALUE_COLUMNS(reader->depth);
+    for (size_t c = 0; c < COL_SCALARS + columns; ++c) {
+        TraceBuffer *buf = c < COL_SCALARS ? &reader->column[c]
+                                           : &reader->value[c - COL_SCALARS];
+        size_t len = 0;
+        if (!file_read_varint(reader->file, &len)) {
+            reader->failed = true;
+            return false;
+        }
+        buf->len = 0;
+        buffer_reserve(buf, len);
+        if (len > 0 && fread(buf->data, 1, len, reader->file) != len) {
+            reader->failed = true;
+            return false;
+        }
+        buf->len = len;
+    }
+    if (reader->column[COL_FLAGS].len < (rows * TRACE_FLAG_BITS + 7) / 8) {
+        reader->failed = true;
+        return false;
+    }
+
+    memset(reader->cursor, 0, sizeof(reader->cursor));
+    memset(reader->value_cursor, 0, columns * sizeof(size_t));
+    reader->rows = rows;
+    reader->row = 0;
+    reader->current.tick = 0;
+    return true;
+}
+
+/* Helper: decode the next entry of integer column c into z */
+static bool reader_integer(TraceReader *reader, size_t c, mpz_ptr z) {
+    const TraceBuffer *buf = &reader->value[c];
+    size_t *cursor = &reader->value_cursor[c];
+    size_t h = 0;
+    if (!varint_read(buf, cursor, &h)) {
+        return false;
+    }
+    if (h == 0) {
+        mpz_set_ui(z, 0UL);
+    } else if (h >= 2) {
+        size_t n = (h - 2) >> 1;
+        if (n > buf->len - *cursor) {
+            return false;
+        }
+        mpz_import(z, n, -1, 1, 0, 0, buf->data + *cursor);
+        *cursor += n;
+        if ((h - 2) & 1) {
+            mpz_neg(z, z);
+        }
+    }
+    /* h == 1: the value of the row above is still in z */
+    return true;
+}
+
+const TraceRow *trace_reader_next(TraceReader *reader) {
+    if (reader->failed || reader->done) {
+        return NULL;
+    }
+    if (reader->row == reader->rows && !reader_load_chunk(reader)) {
+        return NULL;
+    }
+
+    TraceRow *row = &reader->current;
+    size_t delta = 0, meta = 0, sample = 0, stack_size = 0;
+    if (!varint_read(&reader->column[COL_TICK], &reader->cursor[COL_TICK], &delta) ||
+        reader->cursor[COL_MICROTICK] >= reader->column[COL_MICROTICK].len ||
+        !varint_read(&reader->column[COL_SAMPLE], &reader->cursor[COL_SAMPLE], &sample) ||
+        !varint_read(&reader->column[COL_STACK_SIZE], &reader->cursor[COL_STACK_SIZE],
+                     &stack_size)) {
+        reader->failed = true;
+        return NULL;
+    }
+    meta = reader->column[COL_MICROTICK].data[reader->cursor[COL_MICROTICK]++];
+
+    unsigned flags = 0;
+    size_t pos = reader->row * TRACE_FLAG_BITS;
+    for (int i = 0; i < TRACE_FLAG_BITS; ++i, ++pos) {
+        if (reader->column[COL_FLAGS].data[pos / 8] & (1u << (pos % 8))) {
+            flags |= 1u << i;
+        }
+    }
+
+    row->tick += delta;
+    row->microtick = (int)(meta & 0x0f);
+    row->phase = trace_phases[(meta >> 4) & 3];
+    row->flags = flags;
+    row->koppa_sample_index = (int)sample - 1;
+    row->koppa_stack_size = stack_size;
+    for (size_t c = 0; c < TRACE_VALUE_COLUMNS(reader->depth); ++c) {
+        if (!reader_integer(reader, c, row->value[c])) {
+            reader->failed = true;
+            return NULL;
+        }
+    }
+    reader->row++;
+    return row;
+}
+
+void trace_reader_close(TraceReader *reader) {
+    if (!reader) {
+        return;
+    }
+    size_t columns = TRACE_VALUE_COLUMNS(reader->depth);
+    for (size_t c = 0; c < COL_SCALARS; ++c) {
+        buffer_free(&reader->column[c]);
+    }
+    for (size_t c = 0; c < columns; ++c) {
+        buffer_free(&reader->value[c]);
+        mpz_clear(reader->current.value[c]);
+    }
+    free(reader->value);
+    free(reader->value_cursor);
+    free(reader->current.value);
+    free(reader->config);
+    fclose(reader->file);
+    free(reader);
+}
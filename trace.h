@@ -0,0 +1,115 @@
+/* trace.h - Binary Columnar Run Traces
+ *
+ * The binary alternative to events.csv/values.csv (Config.output_format,
+ * trts_simulate --format bin). Integers are stored as raw mpz_export bytes
+ * instead of decimal text, rows are grouped into chunks and each chunk is
+ * stored column by column, so unchanged registers (stack entries, previous
+ * values, triangles) collapse to one byte per row. trts_trace2csv converts
+ * a trace back to the two CSV files.
+ *
+ * File layout (varint = unsigned LEB128):
+ * - "TRTSTRC" and a zero byte, varint TRACE_VERSION, varint koppa stack
+ *   depth D, then the Config as "field=value" text lines ended by a zero
+ *   byte.
+ * - Chunks of up to TRACE_CHUNK_ROWS microtick rows: varint row count,
+ *   then every column as varint byte length followed by its bytes. Chunks
+ *   decode independently. A zero row count ends the trace.
+ *
+ * Columns, one entry per row:
+ * - tick: varint, difference to the previous row of the chunk
+ * - microtick and phase: one byte, microtick | phase << 4 (E, M, R, C = 0-3)
+ * - flags: TRACE_FLAG_BITS bits per row, packed LSB first
+ * - koppa_sample_index + 1, koppa_stack_size: varints
+ * - TRACE_VALUE_COLUMNS(D) integers in values.csv order (koppa_stack_size
+ *   is kept with the scalars). An integer is a varint h: 0 is zero, 1 is
+ *   the row above's value, otherwise (h - 2) >> 1 magnitude bytes follow,
+ *   least significant first, negative if (h - 2) & 1.
+ */
+
+#ifndef TRTS_TRACE_H
+#define TRTS_TRACE_H
+
+#include "config.h"
+#include "csv_writer.h"
+#include "state.h"
+#include <gmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TRACE_VERSION     1
+#define TRACE_CHUNK_ROWS  4096          /* Rows per chunk at most */
+#define TRACE_CHUNK_BYTES (1u << 22)    /* Buffered bytes that close a chunk early */
+#define TRACE_FLAG_BITS   10
+
+/* Event flags, in events.csv column order */
+enum {
+    TRACE_FLAG_RHO_EVENT       = 1u << 0,
+    TRACE_FLAG_PSI_FIRED       = 1u << 1,
+    TRACE_FLAG_MU_ZERO         = 1u << 2,
+    TRACE_FLAG_FORCED_EMISSION = 1u << 3,
+    TRACE_FLAG_RATIO_TRIGGERED = 1u << 4,
+    TRACE_FLAG_TRIPLE_PSI      = 1u << 5,
+    TRACE_FLAG_DUAL_ENGINE     = 1u << 6,
+    TRACE_FLAG_RATIO_THRESHOLD = 1u << 7,
+    TRACE_FLAG_PSI_STRENGTH    = 1u << 8,
+    TRACE_FLAG_SIGN_FLIP       = 1u << 9
+};
+
+/* Integer columns of a trace with koppa stack depth d: eleven registers
+ * plus the stack entries, numerator and denominator each */
+#define TRACE_VALUE_COLUMNS(d) (2 * (11 + (d)))
+
+/* Integer columns before koppa_stack_size in values.csv */
+#define TRACE_VALUES_BEFORE_STACK_SIZE(d) (2 * (6 + (d)))
+
+typedef struct TraceWriter TraceWriter;
+typedef struct TraceReader TraceReader;
+
+/* One decoded row; value holds TRACE_VALUE_COLUMNS(depth) integers */
+typedef struct {
+    size_t tick;
+    int microtick;
+    char phase;
+    unsigned flags;                     /* TRACE_FLAG_* */
+    int koppa_sample_index;
+    size_t koppa_stack_size;
+    mpz_t *value;
+} TraceRow;
+
+/* Koppa stack depth (CSV stack columns) of runs of config */
+size_t trace_depth(const Config *config);
+
+/* Write the events.csv and values.csv header lines for stack depth depth;
+ * row_counts adds the rows column of collapsed quiet events */
+void trace_write_csv_headers(CsvWriter *events, CsvWriter *values, size_t depth,
+                             bool row_counts);
+
+/* Create path and write the header; NULL with errno set on failure */
+TraceWriter *trace_writer_open(const char *path, const Config *config);
+
+/* Append the row of one microtick (same arguments as the CSV logs).
+ * Performs no GMP allocation, so it may run inside a limb arena. */
+void trace_writer_row(TraceWriter *writer, size_t tick, int microtick, char phase,
+                      bool rho_event, bool psi_fired, bool mu_zero,
+                      bool forced_emission, const TRTS_State *state);
+
+/* Flush, end the trace and close the file; false if any write failed */
+bool trace_writer_close(TraceWriter *writer);
+
+/* Open a trace and read its header; NULL with a message in error_buffer */
+TraceReader *trace_reader_open(const char *path, char *error_buffer,
+                               size_t error_capacity);
+
+/* Config text and koppa stack depth from the header */
+const char *trace_reader_config(const TraceReader *reader);
+size_t trace_reader_depth(const TraceReader *reader);
+
+/* Next row (valid until the next call), or NULL at the end of the trace
+ * or when the file is malformed or truncated (trace_reader_failed) */
+const TraceRow *trace_reader_next(TraceReader *reader);
+
+bool trace_reader_failed(const TraceReader *reader);
+
+void trace_reader_close(TraceReader *reader);
+
+#endif /* TRTS_TRACE_H */
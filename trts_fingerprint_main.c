@@ -0,0 +1,293 @@
+/* trts_fingerprint_main.c - Fingerprint Stream and Divergence Finder
+ *
+ * "run" writes one fixed-width record per microtick: tick, microtick,
+ * phase, rolling digest and microtick digest, optionally followed by the
+ * scalar word and all 34 component residues (--registers). "diff" bisects
+ * two such streams on the rolling digest and reports the first diverging
+ * microtick, naming the differing components when both streams carry them.
+ *
+ * Streams from two builds of the tree can be diffed directly.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "fingerprint.h"
+#include "config.h"
+#include "config_loader.h"
+#include "simulate.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+/* Fixed record layout: "TTTTTTTTTTTT MM P RRRRRRRRRRRRRRRR DDDDDDDDDDDDDDDD" */
+#define RECORD_HEAD 18                          /* Up to the rolling digest */
+#define RECORD_WORD 17                          /* " %016" PRIx64 */
+#define RECORD_BASE (RECORD_HEAD + 16 + RECORD_WORD + 1)
+#define RECORD_FULL (RECORD_BASE + (1 + FINGERPRINT_COMPONENTS) * RECORD_WORD)
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s run [options]\n"
+        "       %s diff A B\n"
+        "Run options:\n"
+        "  --config FILE       Load configuration from JSON\n"
+        "  --ticks N           Number of ticks to simulate\n"
+        "  --ups N/D           Initial upsilon seed\n"
+        "  --beta N/D          Initial beta seed\n"
+        "  --koppa N/D         Initial koppa seed\n"
+        "  --registers         Also write the scalar word and all residues\n"
+        "  -o FILE             Output file (default: stdout)\n\n"
+        "diff exits 0 if the streams are identical, 1 if they diverge.\n",
+        prog, prog);
+}
+
+/* Parse rational string "N/D" into raw components (zero numerator -> 0/0) */
+static bool parse_rational(const char *text, Rational *value) {
+    const char *slash = strchr(text, '/');
+    if (!slash) {
+        return false;
+    }
+
+    char num_buf[256];
+    size_t num_len = (size_t)(slash - text);
+    if (num_len >= sizeof(num_buf)) {
+        return false;
+    }
+    memcpy(num_buf, text, num_len);
+    num_buf[num_len] = '\0';
+
+    if (mpz_set_str(value->num, num_buf, 10) != 0 ||
+        mpz_set_str(value->den, slash + 1, 10) != 0) {
+        return false;
+    }
+    if (mpz_sgn(value->num) == 0) {
+        mpz_set_ui(value->den, 0UL);
+    }
+    return true;
+}
+
+typedef struct {
+    FILE *out;
+    bool registers;
+    StateFingerprint fp;
+} RunContext;
+
+static void fingerprint_observer(void *user_data, size_t tick, int microtick,
+                                 char phase, const TRTS_State *state,
+                                 bool rho_event, bool psi_fired,
+                                 bool mu_zero, bool forced_emission) {
+    (void)rho_event;
+    (void)psi_fired;
+    (void)mu_zero;
+    (void)forced_emission;
+    RunContext *ctx = user_data;
+
+    fingerprint_update(&ctx->fp, state);
+    fprintf(ctx->out, "%012zu %02d %c %016" PRIx64 " %016" PRIx64,
+            tick, microtick, phase, ctx->fp.rolling, ctx->fp.digest);
+    if (ctx->registers) {
+        fprintf(ctx->out, " %016" PRIx64, ctx->fp.scalars);
+        for (int i = 0; i < FINGERPRINT_COMPONENTS; ++i) {
+            fprintf(ctx->out, " %016" PRIx64, ctx->fp.residue[i]);
+        }
+    }
+    fputc('\n', ctx->out);
+}
+
+static int run_command(int argc, char **argv) {
+    Config config;
+    config_init(&config);
+    RunContext ctx = {stdout, false, {{0}, 0, 0, 0, 0}};
+    const char *out_path = NULL;
+
+    for (int i = 2; i < argc; ++i) {
+        const char *arg = argv[i];
+        Rational *seed = NULL;
+        if (strcmp(arg, "--ups") == 0) {
+            seed = &config.initial_upsilon;
+        } else if (strcmp(arg, "--beta") == 0) {
+            seed = &config.initial_beta;
+        } else if (strcmp(arg, "--koppa") == 0) {
+            seed = &config.initial_koppa;
+        }
+
+        if (seed && i + 1 < argc) {
+            if (!parse_rational(argv[++i], seed)) {
+                fprintf(stderr, "Invalid seed for %s\n", arg);
+                config_clear(&config);
+                return 2;
+            }
+        } else if (strcmp(arg, "--ticks") == 0 && i + 1 < argc) {
+            config.ticks = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--config") == 0 && i + 1 < argc) {
+            char error[256];
+            if (!config_load_from_file(&config, argv[++i], error, sizeof(error))) {
+                fprintf(stderr, "Config error: %s\n", error);
+                config_clear(&config);
+                return 2;
+            }
+        } else if (strcmp(arg, "--registers") == 0) {
+            ctx.registers = true;
+        } else if (strcmp(arg, "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            print_usage(argv[0]);
+            config_clear(&config);
+            return 2;
+        }
+    }
+
+    /* Skipped ticks would leave holes in the stream */
+    config.enable_cycle_detection = false;
+
+    if (out_path) {
+        ctx.out = fopen(out_path, "w");
+        if (!ctx.out) {
+            perror(out_path);
+            config_clear(&config);
+            return 2;
+        }
+    }
+
+    fingerprint_reset(&ctx.fp);
+    simulate_stream(&config, fingerprint_observer, &ctx);
+
+    int status = 0;
+    if (out_path ? fclose(ctx.out) != 0 : fflush(ctx.out) != 0) {
+        perror(out_path ? out_path : "stdout");
+        status = 2;
+    }
+    config_clear(&config);
+    return status;
+}
+
+/* One fingerprint stream opened for random access */
+typedef struct {
+    const char *path;
+    FILE *file;
+    size_t width;               /* Record length including '\n' */
+    size_t count;               /* Complete records */
+    char record[RECORD_FULL + 2];
+} Stream;
+
+static bool stream_open(Stream *s, const char *path) {
+    s->path = path;
+    s->file = fopen(path, "rb");
+    if (!s->file) {
+        perror(path);
+        return false;
+    }
+    s->width = 0;
+    s->count = 0;
+    if (fgets(s->record, sizeof(s->record), s->file)) {
+        s->width = strlen(s->record);
+        if ((s->width != RECORD_BASE && s->width != RECORD_FULL) ||
+            s->record[s->width - 1] != '\n') {
+            fprintf(stderr, "%s: not a fingerprint stream\n", path);
+            fclose(s->file);
+            return false;
+        }
+        if (fseeko(s->file, 0, SEEK_END) != 0) {
+            perror(path);
+            fclose(s->file);
+            return false;
+        }
+        s->count = (size_t)ftello(s->file) / s->width;
+    }
+    return true;
+}
+
+/* Load record index into s->record */
+static bool stream_read(Stream *s, size_t index) {
+    if (fseeko(s->file, (off_t)(index * s->width), SEEK_SET) != 0 ||
+        fread(s->record, 1, s->width, s->file) != s->width) {
+        fprintf(stderr, "%s: short read at record %zu\n", s->path, index);
+        return false;
+    }
+    s->record[s->width] = '\0';
+    return true;
+}
+
+/* Word field of the current record: 0 = rolling, 1 = digest, 2 = scalars,
+ * 3 + c = residue of component c */
+static uint64_t stream_word(const Stream *s, int field) {
+    return strtoull(s->record + RECORD_HEAD + (size_t)field * RECORD_WORD, NULL, 16);
+}
+
+static void report_record(const char *label, const Stream *s) {
+    printf("  %s: %.*s\n", label, RECORD_HEAD - 1, s->record);
+}
+
+static int diff_command(const char *path_a, const char *path_b) {
+    Stream a, b;
+    if (!stream_open(&a, path_a)) {
+        return 2;
+    }
+    if (!stream_open(&b, path_b)) {
+        fclose(a.file);
+        return 2;
+    }
+
+    /* Rolling digests agree on a prefix and differ after it: bisect for
+     * the first record where they differ */
+    size_t common = a.count < b.count ? a.count : b.count;
+    size_t lo = 0, hi = common;
+    int status = 0;
+    while (lo < hi && status == 0) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (!stream_read(&a, mid) || !stream_read(&b, mid)) {
+            status = 2;
+        } else if (stream_word(&a, 0) == stream_word(&b, 0)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (status == 0 && lo == common) {
+        if (a.count == b.count) {
+            printf("identical: %zu microticks\n", a.count);
+        } else {
+            printf("common prefix of %zu microticks; %s has %zu, %s has %zu\n",
+                   common, path_a, a.count, path_b, b.count);
+            status = 1;
+        }
+    } else if (status == 0) {
+        status = 1;
+        if (!stream_read(&a, lo) || !stream_read(&b, lo)) {
+            status = 2;
+        } else {
+            printf("first divergence at microtick %zu of the stream\n", lo + 1);
+            report_record(path_a, &a);
+            report_record(path_b, &b);
+            if (a.width == RECORD_FULL && b.width == RECORD_FULL) {
+                if (stream_word(&a, 2) != stream_word(&b, 2)) {
+                    printf("  differs: scalars (stack depth, sample index, flags)\n");
+                }
+                for (int c = 0; c < FINGERPRINT_COMPONENTS; ++c) {
+                    if (stream_word(&a, 3 + c) != stream_word(&b, 3 + c)) {
+                        printf("  differs: %s\n", fingerprint_component_names[c]);
+                    }
+                }
+            }
+        }
+    }
+
+    fclose(a.file);
+    fclose(b.file);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "run") == 0) {
+        return run_command(argc, argv);
+    }
+    if (argc == 4 && strcmp(argv[1], "diff") == 0) {
+        return diff_command(argv[2], argv[3]);
+    }
+    print_usage(argv[0]);
+    return 2;
+}
@@ -25,6 +25,7 @@
 #include <gmp.h>
 
 #include "config.h"
+#include "csv_writer.h"
 #include "state.h"
 #include "engine.h"
 #include "koppa.h"
@@ -62,24 +63,29 @@ static bool parse_seed(const char *text, mpq_t out) {
 /* Print CSV header and a single values row (mirrors values.csv layout used elsewhere).
    We print numerator and denominator for upsilon, beta and koppa plus a few
    bookkeeping fields (koppa stack numerators/denominators and stack size). */
-static void print_csv_header(FILE *f) {
-    fprintf(f,
+static void print_csv_header(CsvWriter *f) {
+    csv_writer_text(f,
         "tick,mt,upsilon_num,upsilon_den,beta_num,beta_den,koppa_num,koppa_den,"
         "koppa_stack0_num,koppa_stack0_den,koppa_stack1_num,koppa_stack1_den,"
         "koppa_stack2_num,koppa_stack2_den,koppa_stack3_num,koppa_stack3_den,"
         "koppa_stack_size\n");
 }
 
-static void print_state_row(FILE *f, size_t tick, int microtick, const TRTS_State *s) {
-    gmp_fprintf(f, "%zu,%d,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd,",
-                tick, microtick,
-                mpq_numref(s->upsilon), mpq_denref(s->upsilon),
-                mpq_numref(s->beta), mpq_denref(s->beta),
-                mpq_numref(s->koppa), mpq_denref(s->koppa));
+static void print_state_row(CsvWriter *f, size_t tick, int microtick, const TRTS_State *s) {
+    csv_put_size(f, tick);
+    csv_put_int(f, microtick);
+    csv_put_mpz(f, mpq_numref(s->upsilon));
+    csv_put_mpz(f, mpq_denref(s->upsilon));
+    csv_put_mpz(f, mpq_numref(s->beta));
+    csv_put_mpz(f, mpq_denref(s->beta));
+    csv_put_mpz(f, mpq_numref(s->koppa));
+    csv_put_mpz(f, mpq_denref(s->koppa));
     for (size_t i = 0; i < 4; ++i) {
-        gmp_fprintf(f, "%Zd,%Zd,", mpq_numref(s->koppa_stack[i]), mpq_denref(s->koppa_stack[i]));
+        csv_put_mpz(f, mpq_numref(s->koppa_stack[i]));
+        csv_put_mpz(f, mpq_denref(s->koppa_stack[i]));
     }
-    fprintf(f, "%zu\n", s->koppa_stack_size);
+    csv_put_size(f, s->koppa_stack_size);
+    csv_end_row(f);
 }
 
 /* Minimal runtime configuration parsed from CLI */
@@ -158,14 +164,11 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     }
 
-    FILE *out = stdout;
-    if (rc.output_path) {
-        out = fopen(rc.output_path, "w");
-        if (!out) {
-            perror("opening output file");
-            runconfig_clear(&rc);
-            return EXIT_FAILURE;
-        }
+    CsvWriter *out = csv_writer_open(rc.output_path);
+    if (!out) {
+        perror("opening output file");
+        runconfig_clear(&rc);
+        return EXIT_FAILURE;
     }
 
     /* Build minimal Config and initial TRTS_State */
@@ -245,7 +248,10 @@ int main(int argc, char **argv) {
     config_clear(&cfg);
     runconfig_clear(&rc);
 
-    if (out != stdout) fclose(out);
+    if (!csv_writer_close(out)) {
+        fprintf(stderr, "write failed\n");
+        return EXIT_FAILURE;
+    }
     return EXIT_SUCCESS;
 }
 
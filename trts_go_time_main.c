@@ -5,6 +5,7 @@
  */
 
 #include "config.h"
+#include "csv_writer.h"
 #include "state.h"
 #include "engine.h"
 #include "koppa.h"
@@ -14,7 +15,7 @@
 #include <stdlib.h>
 #include <string.h>
 
-static bool parse_rational(const char *text, mpq_t value) {
+static bool parse_rational(const char *text, Rational *value) {
     if (!text) return false;
     const char *slash = strchr(text, '/');
     if (!slash) return false;
@@ -39,28 +40,27 @@ static bool parse_rational(const char *text, mpq_t value) {
         return false;
     }
     
-    mpq_set_num(value, n);
-    mpq_set_den(value, d);
-    if (mpz_sgn(n) == 0) {
-        mpz_set_ui(d, 0UL);
-        mpq_set_den(value, d);
-    }
+    rational_set_components(value, n, d);
     
     mpz_clear(n);
     mpz_clear(d);
     return true;
 }
 
-static void print_csv_header(FILE *f) {
-    fprintf(f, "tick,mt,upsilon_num,upsilon_den,beta_num,beta_den,koppa_num,koppa_den\n");
+static void print_csv_header(CsvWriter *out) {
+    csv_writer_text(out, "tick,mt,upsilon_num,upsilon_den,beta_num,beta_den,koppa_num,koppa_den\n");
 }
 
-static void print_state_row(FILE *f, size_t tick, int mt, const TRTS_State *s) {
-    gmp_fprintf(f, "%zu,%d,%Zd,%Zd,%Zd,%Zd,%Zd,%Zd\n",
-                tick, mt,
-                mpq_numref(s->upsilon), mpq_denref(s->upsilon),
-                mpq_numref(s->beta), mpq_denref(s->beta),
-                mpq_numref(s->koppa), mpq_denref(s->koppa));
+static void print_state_row(CsvWriter *out, size_t tick, int mt, const TRTS_State *s) {
+    csv_put_size(out, tick);
+    csv_put_int(out, mt);
+    csv_put_mpz(out, s->upsilon.num);
+    csv_put_mpz(out, s->upsilon.den);
+    csv_put_mpz(out, s->beta.num);
+    csv_put_mpz(out, s->beta.den);
+    csv_put_mpz(out, s->koppa.num);
+    csv_put_mpz(out, s->koppa.den);
+    csv_end_row(out);
 }
 
 int main(int argc, char **argv) {
@@ -68,39 +68,41 @@ int main(int argc, char **argv) {
     config_init(&cfg);
     cfg.ticks = 30;
     
-    FILE *out = stdout;
+    const char *output_path = NULL;
     
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
             cfg.ticks = (size_t)strtoull(argv[++i], NULL, 10);
         } else if (strcmp(argv[i], "--ups") == 0 && i + 1 < argc) {
-            if (!parse_rational(argv[++i], cfg.initial_upsilon)) {
+            if (!parse_rational(argv[++i], &cfg.initial_upsilon)) {
                 fprintf(stderr, "Invalid upsilon\n");
                 config_clear(&cfg);
                 return 1;
             }
         } else if (strcmp(argv[i], "--beta") == 0 && i + 1 < argc) {
-            if (!parse_rational(argv[++i], cfg.initial_beta)) {
+            if (!parse_rational(argv[++i], &cfg.initial_beta)) {
                 fprintf(stderr, "Invalid beta\n");
                 config_clear(&cfg);
                 return 1;
             }
         } else if (strcmp(argv[i], "--koppa") == 0 && i + 1 < argc) {
-            if (!parse_rational(argv[++i], cfg.initial_koppa)) {
+            if (!parse_rational(argv[++i], &cfg.initial_koppa)) {
                 fprintf(stderr, "Invalid koppa\n");
                 config_clear(&cfg);
                 return 1;
             }
         } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
-            out = fopen(argv[++i], "w");
-            if (!out) {
-                perror("open output");
-                config_clear(&cfg);
-                return 1;
-            }
+            output_path = argv[++i];
         }
     }
     
+    CsvWriter *out = csv_writer_open(output_path);
+    if (!out) {
+        perror("open output");
+        config_clear(&cfg);
+        return 1;
+    }
+    
     TRTS_State state;
     state_init(&state);
     state_reset(&state, &cfg);
@@ -137,8 +139,9 @@ int main(int argc, char **argv) {
     state_clear(&state);
     config_clear(&cfg);
     
-    if (out != stdout) {
-        fclose(out);
+    if (!csv_writer_close(out)) {
+        fprintf(stderr, "write failed\n");
+        return 1;
     }
     
     return 0;
@@ -1,9 +1,12 @@
 /* trts_simulate_main.c - Simple TRTS Simulator
  *
- * Runs TRTS simulation and writes events.csv and values.csv.
+ * Runs TRTS simulation and writes events.csv and values.csv, or a binary
+ * trace.bin (--format bin).
  */
 
+#include "arena.h"
 #include "config.h"
+#include "pattern.h"
 #include "simulate.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,13 +24,25 @@ static void print_usage(const char *prog) {
         "  --psi-mode N        Psi mode 0-3 (default: 0=MSTEP)\n"
         "  --triple-psi        Enable 3-way psi transform\n"
         "  --multi-level       Enable 4-level koppa stack\n"
+        "  --arena             Pool GMP limbs in a per-run arena\n"
+        "  --detect-cycles     Skip ahead when the state repeats exactly\n"
+        "  --format csv|bin    Output format (default: csv)\n"
+        "  --every N           Write every Nth tick (plus any --only-events rows)\n"
+        "  --ticks-from N      First tick written\n"
+        "  --ticks-to N        Last tick written\n"
+        "  --only-events LIST  Write microticks with psi,rho,mu_zero,ratio events\n"
+        "  --final-only        Write only the final state\n"
+        "  --multimod          Final-only: run admissible plans in residue lanes\n"
+        "  --multimod-threads N  Worker threads for the residue lanes\n"
+        "  --queue N           Rows buffered for the writer thread (0: write inline)\n"
         "  -h, --help          Show this help\n\n"
-        "Outputs: events.csv and values.csv\n",
+        "Outputs: events.csv and values.csv, or trace.bin with --format bin\n"
+        "(trts_trace2csv converts trace.bin to the CSV files)\n",
         prog);
 }
 
 /* Parse rational string "N/D" */
-static bool parse_rational(const char *text, mpq_t value) {
+static bool parse_rational(const char *text, Rational *value) {
     if (!text || !value) {
         return false;
     }
@@ -60,14 +75,8 @@ static bool parse_rational(const char *text, mpq_t value) {
         return false;
     }
     
-    mpq_set_num(value, num);
-    mpq_set_den(value, den);
-    
-    /* Enforce 0/0 for zero numerator */
-    if (mpz_sgn(num) == 0) {
-        mpz_set_ui(den, 0UL);
-        mpq_set_den(value, den);
-    }
+    /* Zero numerator is stored as 0/0 */
+    rational_set_components(value, num, den);
     
     mpz_clear(num);
     mpz_clear(den);
@@ -83,19 +92,19 @@ int main(int argc, char **argv) {
         if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
             config.ticks = (size_t)strtoull(argv[++i], NULL, 10);
         } else if (strcmp(argv[i], "--ups") == 0 && i + 1 < argc) {
-            if (!parse_rational(argv[++i], config.initial_upsilon)) {
+            if (!parse_rational(argv[++i], &config.initial_upsilon)) {
                 fprintf(stderr, "Invalid upsilon seed\n");
                 config_clear(&config);
                 return 1;
             }
         } else if (strcmp(argv[i], "--beta") == 0 && i + 1 < argc) {
-            if (!parse_rational(argv[++i], config.initial_beta)) {
+            if (!parse_rational(argv[++i], &config.initial_beta)) {
                 fprintf(stderr, "Invalid beta seed\n");
                 config_clear(&config);
                 return 1;
             }
         } else if (strcmp(argv[i], "--koppa") == 0 && i + 1 < argc) {
-            if (!parse_rational(argv[++i], config.initial_koppa)) {
+            if (!parse_rational(argv[++i], &config.initial_koppa)) {
                 fprintf(stderr, "Invalid koppa seed\n");
                 config_clear(&config);
                 return 1;
@@ -114,6 +123,42 @@ int main(int argc, char **argv) {
             config.triple_psi_mode = true;
         } else if (strcmp(argv[i], "--multi-level") == 0) {
             config.multi_level_koppa = true;
+        } else if (strcmp(argv[i], "--arena") == 0) {
+            config.enable_limb_arena = true;
+        } else if (strcmp(argv[i], "--detect-cycles") == 0) {
+            config.enable_cycle_detection = true;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char *format = argv[++i];
+            if (strcmp(format, "csv") == 0) {
+                config.output_format = OUTPUT_FORMAT_CSV;
+            } else if (strcmp(format, "bin") == 0) {
+                config.output_format = OUTPUT_FORMAT_BINARY;
+            } else {
+                fprintf(stderr, "Invalid format: %s\n", format);
+                config_clear(&config);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--every") == 0 && i + 1 < argc) {
+            config.output_every = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--ticks-from") == 0 && i + 1 < argc) {
+            config.output_tick_from = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--ticks-to") == 0 && i + 1 < argc) {
+            config.output_tick_to = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--only-events") == 0 && i + 1 < argc) {
+            const char *events = argv[++i];
+            if (!config_parse_output_events(events, &config.output_events)) {
+                fprintf(stderr, "Invalid event list: %s\n", events);
+                config_clear(&config);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--final-only") == 0) {
+            config.output_final_only = true;
+        } else if (strcmp(argv[i], "--multimod") == 0) {
+            config.enable_multimodular_engine = true;
+        } else if (strcmp(argv[i], "--multimod-threads") == 0 && i + 1 < argc) {
+            config.multimodular_threads = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--queue") == 0 && i + 1 < argc) {
+            config.output_queue_rows = (size_t)strtoull(argv[++i], NULL, 10);
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             config_clear(&config);
@@ -137,7 +182,25 @@ int main(int argc, char **argv) {
     
     simulate(&config);
     
-    printf("Complete. Output written to events.csv and values.csv\n");
+    if (config.output_format == OUTPUT_FORMAT_BINARY) {
+        printf("Complete. Output written to trace.bin\n");
+    } else {
+        printf("Complete. Output written to events.csv and values.csv\n");
+    }
+    if (config.enable_limb_arena) {
+        ArenaStats stats = arena_last_stats();
+        printf("Limb arena: peak %zu bytes, %zu allocations (%zu reused)\n",
+               stats.peak_bytes, stats.allocations, stats.reused);
+    }
+    PatternCacheStats cache = pattern_cache_stats();
+    if (cache.lookups > 0) {
+        printf("Pattern cache: %zu of %zu lookups hit, %zu evictions, %zu uncached\n",
+               cache.hits, cache.lookups, cache.evictions, cache.uncached);
+    }
+    if (cache.too_large > 0) {
+        printf("Prime tests: %zu values above %zu bits not tested\n",
+               cache.too_large, config.prime_test_max_bits);
+    }
     
     config_clear(&config);
     return 0;